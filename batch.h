@@ -0,0 +1,211 @@
+// solve a file of puzzles on a pool of worker threads, the answers are still written in input order
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "sudoku_io.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include "validate.h"
+
+const size_t batchChunkSize = 256; // puzzles handed to a worker at once
+
+// a run of consecutive puzzles from the input and the text of their answers
+struct BatchChunk
+{
+    std::vector<Grid> grids;
+    bool found[batchChunkSize]; // whether each grid was solved
+    std::vector<Grid> puzzles;  // the grids as read, kept only when validating
+    bool valid[batchChunkSize]; // whether each answer passed validation
+    std::string output;
+    long solved = 0;
+    long invalid = 0; // answers that failed validation
+    bool done = false;
+};
+
+// solve every puzzle in the chunk, the answers are formatted into the chunk so workers never share a writer
+// batch solvers get the whole chunk at once, the rest get one puzzle at a time
+// with validate every answer is checked against its puzzle in one batch, and a wrong one is never written
+inline void solveChunk(BatchChunk &chunk, const Solver &solver, bool validate)
+{
+    chunk.output.clear();
+    chunk.solved = 0;
+    chunk.invalid = 0;
+    if (validate)
+        chunk.puzzles.assign(chunk.grids.begin(), chunk.grids.end());
+
+    if (solver.solveBatch)
+        solver.solveBatch(chunk.grids.data(), chunk.found, chunk.grids.size());
+    else
+        for (size_t i = 0; i < chunk.grids.size(); ++i)
+            chunk.found[i] = solver.solve(chunk.grids[i].cells);
+
+    if (validate)
+        validateBatch(chunk.puzzles.data(), chunk.grids.data(), chunk.valid, chunk.grids.size());
+
+    char line[82];
+    for (size_t n = 0; n < chunk.grids.size(); ++n)
+    {
+        const Grid &grid = chunk.grids[n];
+        if (chunk.found[n] && validate && !chunk.valid[n])
+        {
+            ++chunk.invalid;
+            chunk.output.append("Invalid solution!\n");
+        }
+        else if (chunk.found[n])
+        {
+            ++chunk.solved;
+            for (int i = 0; i < 81; ++i)
+                line[i] = static_cast<char>('0' + grid.cells[i / 9][i % 9]);
+            line[81] = '\n';
+            chunk.output.append(line, 82);
+        }
+        else
+        {
+            chunk.output.append("No solution found!\n");
+        }
+    }
+}
+
+// Same output as solveStream but the puzzles are split into chunks and solved on the pool
+// Only twice as many chunks as workers are in flight, so memory stays flat however big the input is
+inline int solveStreamParallel(const char *path, const Solver &solver, ThreadPool &pool, bool validate = false)
+{
+    PuzzleReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    OutputWriter writer;
+    const long slots = pool.size() * 2;
+    std::vector<BatchChunk> chunks(slots);
+    std::mutex lock;
+    std::condition_variable finished;
+#ifdef SUDOKU_STATS
+    SolverStats workerStats;
+#endif
+
+    long nextToRead = 0, nextToWrite = 0;
+    long puzzles = 0, solved = 0, invalid = 0, invalidLine = 0;
+    bool moreInput = true, largeLine = false;
+
+    Timer timer;
+
+    while (moreInput || nextToWrite < nextToRead)
+    {
+        // wait for the oldest chunk when every slot is busy or there is nothing left to read
+        bool full = nextToRead - nextToWrite == slots;
+        if (full || !moreInput)
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            finished.wait(guard, [&]
+                          { return chunks[nextToWrite % slots].done; });
+        }
+
+        // write every finished chunk at the front of the queue
+        while (nextToWrite < nextToRead)
+        {
+            BatchChunk &chunk = chunks[nextToWrite % slots];
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!chunk.done)
+                    break;
+                chunk.done = false;
+            }
+            writer.write(chunk.output.data(), chunk.output.size());
+            solved += chunk.solved;
+            invalid += chunk.invalid;
+            ++nextToWrite;
+        }
+
+        if (!moreInput || nextToRead - nextToWrite == slots)
+            continue;
+
+        // fill the next free slot, reusing its vectors from the last time round
+        BatchChunk &chunk = chunks[nextToRead % slots];
+        chunk.grids.clear();
+        Grid grid;
+        while (chunk.grids.size() < batchChunkSize)
+        {
+            // read like nextPuzzle, but keep the line to tell a 16x16 or 25x25 puzzle from a broken one
+            bool valid;
+            if (reader.isPacked())
+            {
+                const unsigned char *record;
+                if (!reader.nextRecord(record))
+                {
+                    moreInput = false;
+                    break;
+                }
+                valid = unpackGrid(record, grid.cells);
+            }
+            else
+            {
+                const char *line;
+                size_t length;
+                if (!reader.nextLine(line, length))
+                {
+                    moreInput = false;
+                    break;
+                }
+                valid = parsePuzzle(line, length, grid.cells);
+                size_t cells = puzzleLength(line, length);
+                largeLine = cells == 256 || cells == 625;
+            }
+            if (!valid)
+            {
+                invalidLine = reader.lineNumber();
+                moreInput = false;
+                break;
+            }
+            chunk.grids.push_back(grid);
+        }
+
+        if (chunk.grids.empty())
+            continue;
+
+        puzzles += chunk.grids.size();
+        ++nextToRead;
+        pool.submit([&](int)
+                    {
+            solveChunk(chunk, solver, validate);
+
+            std::lock_guard<std::mutex> guard(lock);
+#ifdef SUDOKU_STATS
+            workerStats += solverStats;
+            solverStats = SolverStats();
+#endif
+            chunk.done = true;
+            finished.notify_one(); });
+    }
+    writer.flush();
+
+#ifdef SUDOKU_STATS
+    solverStats += workerStats;
+#endif
+
+    if (invalidLine != 0)
+    {
+        std::cerr << "Invalid puzzle on " << reader.lineName() << " " << invalidLine << "\n";
+        if (largeLine && !solver.solveAnySize)
+            std::cerr << solver.name << " only solves 9x9 puzzles, try --solver=v11 without --threads\n";
+        else if (largeLine)
+            std::cerr << "only 9x9 puzzles are solved on the threaded path, run 16x16 and 25x25 files without "
+                         "--threads\n";
+        return 1;
+    }
+
+    std::cerr << "Solved " << solved << " of " << puzzles << " puzzles in " << timer.elapsedMilliseconds()
+              << " milliseconds on " << pool.size() << " threads\n";
+    if (validate)
+        std::cerr << invalid << " answers failed validation\n";
+    return invalid == 0 ? 0 : 1;
+}
+
+#endif
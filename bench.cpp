@@ -0,0 +1,367 @@
+// benchmark every solver over the graded puzzle corpus in puzzles/
+
+#include <iostream> // Includes the standard input/output stream library
+#include <string>
+#include <vector>
+#include <algorithm> // For std::sort
+#include <cmath>     // For std::ceil
+#include <cstdio>    // For snprintf
+#include <cstdlib>   // For atoi
+#include <cstring>   // For strncmp
+#include <memory>    // For unique_ptr
+#include <csignal>   // For kill
+#include <poll.h>     // For waiting on a child with a timeout
+#include <sys/wait.h> // For waitpid
+#include "solvers.h"
+#include "sudoku_io.h"
+#include "validate.h"
+
+// summary of one solver on one bucket, sent from the child process back to the parent
+struct BenchResult
+{
+    long puzzles = 0;
+    int trials = 0;
+    long samples = 0;
+    double minUs = 0, medianUs = 0, p99Us = 0, maxUs = 0;
+    double puzzlesPerSecond = 0;
+    long unsolved = 0; // solver gave up or left empty cells
+    long wrong = 0;    // solver returned a grid that is not a solution of the puzzle
+};
+
+struct Options
+{
+    std::vector<std::string> solverNames;
+    std::vector<std::string> buckets = {"easy", "hard", "17clue", "pathological"};
+    std::string directory = "puzzles";
+    std::string format = "table";
+    int warmup = 1;
+    int trials = 5;
+    int timeoutSeconds = 60;
+};
+
+std::vector<std::string> splitList(const char *list)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char *c = list;; ++c)
+    {
+        if (*c == ',' || *c == '\0')
+        {
+            if (!item.empty())
+                items.push_back(item);
+            item.clear();
+            if (*c == '\0')
+                break;
+        }
+        else
+        {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+bool loadBucket(const std::string &path, std::vector<Grid> &puzzles)
+{
+    PuzzleReader reader;
+    if (!reader.open(path.c_str()))
+        return false;
+
+    Grid grid;
+    bool valid;
+    while (nextPuzzle(reader, grid.cells, valid))
+    {
+        if (!valid)
+        {
+            std::cerr << path << ": invalid puzzle on " << reader.lineName() << " " << reader.lineNumber() << "\n";
+            return false;
+        }
+        puzzles.push_back(grid);
+    }
+    return true;
+}
+
+// true when the solver left cells empty (v5 only propagates, it does not search)
+bool hasEmptyCells(const int (&grid)[9][9])
+{
+    for (int row = 0; row < 9; ++row)
+        for (int col = 0; col < 9; ++col)
+            if (grid[row][col] == 0)
+                return true;
+    return false;
+}
+
+// count a wrong or missing answer, done once for each puzzle of a bucket
+void checkAnswer(const Grid &puzzle, const Grid &grid, bool solved, BenchResult &result)
+{
+    if (!solved || hasEmptyCells(grid.cells))
+        ++result.unsolved;
+    else if (!validateSolution(puzzle.cells, grid.cells))
+        ++result.wrong;
+}
+
+// warm-up passes, then timed trials with every puzzle solved once per trial
+BenchResult runBucket(const Solver &solver, const std::vector<Grid> &puzzles, const Options &options)
+{
+    BenchResult result;
+    result.puzzles = puzzles.size();
+    result.trials = options.trials;
+
+    // batch solvers take the whole bucket in one call
+    std::vector<Grid> batch;
+    std::unique_ptr<bool[]> solved(new bool[puzzles.size()]);
+
+    Grid grid;
+    for (int pass = 0; pass < options.warmup; ++pass)
+    {
+        if (solver.solveBatch)
+        {
+            batch = puzzles;
+            solver.solveBatch(batch.data(), solved.get(), batch.size());
+        }
+
+        for (size_t i = 0; i < puzzles.size(); ++i)
+        {
+            const Grid &puzzle = puzzles[i];
+            if (solver.solveBatch)
+            {
+                grid = batch[i];
+            }
+            else
+            {
+                grid = puzzle;
+                solved[i] = solver.solve(grid.cells);
+            }
+
+            // correctness is only counted on the first pass
+            if (pass == 0)
+                checkAnswer(puzzle, grid, solved[i], result);
+        }
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(puzzles.size() * options.trials);
+    double totalUs = 0;
+    size_t solvedCount = 0;
+
+    for (int trial = 0; trial < options.trials; ++trial)
+    {
+        // without warm-up passes the answers of the first trial are checked instead, outside the timed part
+        bool check = trial == 0 && options.warmup == 0;
+
+        if (solver.solveBatch)
+        {
+            // a batch has no per puzzle latency, so each trial gives one sample of the average
+            batch = puzzles;
+            Timer timer;
+            solver.solveBatch(batch.data(), solved.get(), batch.size());
+            double us = timer.elapsedMilliseconds() * 1000.0;
+            if (!puzzles.empty())
+                latencies.push_back(us / puzzles.size());
+            totalUs += us;
+            solvedCount += puzzles.size();
+            if (check)
+                for (size_t i = 0; i < puzzles.size(); ++i)
+                    checkAnswer(puzzles[i], batch[i], solved[i], result);
+            continue;
+        }
+
+        for (const Grid &puzzle : puzzles)
+        {
+            grid = puzzle;
+            Timer timer;
+            bool found = solver.solve(grid.cells);
+            double us = timer.elapsedMilliseconds() * 1000.0;
+            latencies.push_back(us);
+            totalUs += us;
+            ++solvedCount;
+            if (check)
+                checkAnswer(puzzle, grid, found, result);
+        }
+    }
+
+    if (latencies.empty())
+        return result;
+
+    std::sort(latencies.begin(), latencies.end());
+    size_t n = latencies.size();
+    result.samples = n;
+    result.minUs = latencies.front();
+    result.medianUs = n % 2 ? latencies[n / 2] : (latencies[n / 2 - 1] + latencies[n / 2]) / 2;
+    result.p99Us = latencies[static_cast<size_t>(std::ceil(0.99 * n)) - 1]; // nearest rank
+    result.maxUs = latencies.back();
+    result.puzzlesPerSecond = totalUs > 0 ? solvedCount / (totalUs / 1e6) : 0;
+    return result;
+}
+
+// run the bucket in a child process so a solver stuck on a pathological puzzle can be killed
+// returns the status for the report: ok, timeout or crashed
+const char *runIsolated(const Solver &solver, const std::vector<Grid> &puzzles, const Options &options, BenchResult &result)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        return "crashed";
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(fds[0]);
+        BenchResult childResult = runBucket(solver, puzzles, options);
+        ssize_t written = write(fds[1], &childResult, sizeof(childResult));
+        _exit(written == sizeof(childResult) ? 0 : 1);
+    }
+    close(fds[1]);
+
+    // the pipe becomes readable when the child writes its result or dies
+    struct pollfd waitFor = {fds[0], POLLIN, 0};
+    const char *status = "ok";
+    if (poll(&waitFor, 1, options.timeoutSeconds * 1000) <= 0)
+    {
+        kill(child, SIGKILL);
+        status = "timeout";
+    }
+    else if (read(fds[0], &result, sizeof(result)) != sizeof(result))
+    {
+        status = "crashed";
+    }
+
+    close(fds[0]);
+    waitpid(child, nullptr, 0);
+    return status;
+}
+
+void printRow(const Options &options, const char *solver, const std::string &bucket, const BenchResult &r, const char *status, bool first)
+{
+    if (options.format == "csv")
+    {
+        std::cout << solver << "," << bucket << "," << status << "," << r.puzzles << "," << r.trials << ","
+                  << r.samples << "," << r.minUs << "," << r.medianUs << "," << r.p99Us << "," << r.maxUs << ","
+                  << r.puzzlesPerSecond << "," << r.unsolved << "," << r.wrong << "\n";
+    }
+    else if (options.format == "json")
+    {
+        std::cout << (first ? "  " : ",\n  ")
+                  << "{\"solver\": \"" << solver << "\", \"bucket\": \"" << bucket << "\", \"status\": \"" << status
+                  << "\", \"puzzles\": " << r.puzzles << ", \"trials\": " << r.trials << ", \"samples\": " << r.samples
+                  << ", \"min_us\": " << r.minUs << ", \"median_us\": " << r.medianUs << ", \"p99_us\": " << r.p99Us
+                  << ", \"max_us\": " << r.maxUs << ", \"puzzles_per_sec\": " << r.puzzlesPerSecond
+                  << ", \"unsolved\": " << r.unsolved << ", \"wrong\": " << r.wrong << "}";
+    }
+    else
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "%-6s %-13s %-8s %8.2f %10.2f %10.2f %11.2f %12.0f %4ld %4ld\n",
+                 solver, bucket.c_str(), status, r.minUs, r.medianUs, r.p99Us, r.maxUs, r.puzzlesPerSecond,
+                 r.unsolved, r.wrong);
+        std::cout << line;
+    }
+}
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --solvers=v1,v2,...   solvers to run (default all)\n"
+              << "  --buckets=easy,...    buckets to run: easy, hard, 17clue, pathological (default all)\n"
+              << "  --dir=PATH            directory holding BUCKET.txt files (default puzzles)\n"
+              << "  --warmup=N            untimed passes before measuring (default 1)\n"
+              << "  --trials=N            timed passes over every puzzle (default 5)\n"
+              << "  --timeout=SECONDS     give up on a solver/bucket after this long (default 60)\n"
+              << "  --format=FORMAT       table, csv or json (default table)\n";
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--solvers=", 10) == 0)
+            options.solverNames = splitList(arg + 10);
+        else if (strncmp(arg, "--buckets=", 10) == 0)
+            options.buckets = splitList(arg + 10);
+        else if (strncmp(arg, "--dir=", 6) == 0)
+            options.directory = arg + 6;
+        else if (strncmp(arg, "--warmup=", 9) == 0)
+            options.warmup = atoi(arg + 9);
+        else if (strncmp(arg, "--trials=", 9) == 0)
+            options.trials = atoi(arg + 9);
+        else if (strncmp(arg, "--timeout=", 10) == 0)
+            options.timeoutSeconds = atoi(arg + 10);
+        else if (strncmp(arg, "--format=", 9) == 0)
+            options.format = arg + 9;
+        else
+        {
+            printUsage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (options.format != "table" && options.format != "csv" && options.format != "json")
+    {
+        std::cerr << "Unknown format " << options.format << "\n";
+        return 1;
+    }
+    if (options.trials < 1 || options.warmup < 0 || options.timeoutSeconds < 1)
+    {
+        std::cerr << "Need at least one trial and a positive timeout\n";
+        return 1;
+    }
+
+    std::vector<const Solver *> selected;
+    if (options.solverNames.empty())
+    {
+        for (size_t s = 0; s < solverCount; ++s)
+            selected.push_back(&solvers[s]);
+    }
+    for (const std::string &name : options.solverNames)
+    {
+        const Solver *solver = findSolver(name.c_str());
+        if (solver == nullptr)
+        {
+            std::cerr << "Unknown solver " << name << "\n";
+            return 1;
+        }
+        selected.push_back(solver);
+    }
+
+    // load every bucket up front so the children only solve
+    std::vector<std::vector<Grid>> corpus(options.buckets.size());
+    for (size_t b = 0; b < options.buckets.size(); ++b)
+    {
+        std::string path = options.directory + "/" + options.buckets[b] + ".txt";
+        if (!loadBucket(path, corpus[b]))
+        {
+            std::cerr << "Could not load " << path << "\n";
+            return 1;
+        }
+    }
+
+    if (options.format == "csv")
+        std::cout << "solver,bucket,status,puzzles,trials,samples,min_us,median_us,p99_us,max_us,puzzles_per_sec,unsolved,wrong\n";
+    else if (options.format == "json")
+        std::cout << "[\n";
+    else
+        std::cout << "solver bucket        status     min_us  median_us     p99_us      max_us  puzzles/sec  uns  wrg\n";
+
+    bool first = true;
+    for (const Solver *solver : selected)
+    {
+        for (size_t b = 0; b < options.buckets.size(); ++b)
+        {
+            BenchResult result;
+            result.puzzles = corpus[b].size();
+            result.trials = options.trials;
+            const char *status = runIsolated(*solver, corpus[b], options, result);
+            if (strcmp(status, "ok") == 0 && (result.wrong > 0 || result.unsolved > 0))
+                status = "failed";
+
+            printRow(options, solver->name, options.buckets[b], result, status, first);
+            first = false;
+            std::cout.flush();
+        }
+    }
+
+    if (options.format == "json")
+        std::cout << "\n]\n";
+    return 0;
+}
@@ -0,0 +1,185 @@
+// every shard has a fixed array of entries, an open addressing index of the entries by hash (linear probing, at
+// most half full) and a recency list threaded through the entries, so a lookup, an insertion and an eviction
+// each take a probe or two and a few link updates. Nothing is allocated after the cache is built.
+
+#include <cstring> // For memcpy
+#include "cache.h"
+#include "validate.h"
+
+const uint32_t noEntry = UINT32_MAX;
+
+struct SolutionCache::Shard
+{
+    mutable std::mutex lock;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> index; // entry + 1 for every slot in use, 0 for an empty slot
+    size_t indexMask;
+    uint32_t used = 0;
+    uint32_t newest = noEntry, oldest = noEntry;
+    CacheStats stats;
+
+    explicit Shard(size_t capacity) : entries(capacity)
+    {
+        size_t slots = 1;
+        while (slots < capacity * 2)
+            slots *= 2;
+        index.assign(slots, 0);
+        indexMask = slots - 1;
+        stats.capacity = capacity;
+    }
+
+    // slot of the hash in the index, or the empty slot where it would go
+    size_t find(uint64_t hash) const
+    {
+        size_t slot = hash & indexMask;
+        while (index[slot] != 0 && entries[index[slot] - 1].hash != hash)
+            slot = (slot + 1) & indexMask;
+        return slot;
+    }
+
+    // empty the slot and shift later entries of the same probe run back, so no tombstones build up
+    void unindex(size_t hole)
+    {
+        for (size_t slot = (hole + 1) & indexMask; index[slot] != 0; slot = (slot + 1) & indexMask)
+        {
+            size_t home = entries[index[slot] - 1].hash & indexMask;
+            if (((slot - home) & indexMask) >= ((slot - hole) & indexMask))
+            {
+                index[hole] = index[slot];
+                hole = slot;
+            }
+        }
+        index[hole] = 0;
+    }
+
+    void unlink(uint32_t e)
+    {
+        Entry &entry = entries[e];
+        (entry.newer == noEntry ? newest : entries[entry.newer].older) = entry.older;
+        (entry.older == noEntry ? oldest : entries[entry.older].newer) = entry.newer;
+    }
+
+    void pushNewest(uint32_t e)
+    {
+        entries[e].newer = noEntry;
+        entries[e].older = newest;
+        (newest == noEntry ? oldest : entries[newest].newer) = e;
+        newest = e;
+    }
+};
+
+SolutionCache::SolutionCache(size_t bytes, int shardCount)
+{
+    // the most entries a shard can hold with its index, rounded up to a power of two, inside its share of bytes
+    size_t shardBytes = bytes / shardCount;
+    size_t perShard = 0;
+    for (size_t slots = 2; slots * sizeof(uint32_t) < shardBytes; slots *= 2)
+    {
+        size_t capacity = (shardBytes - slots * sizeof(uint32_t)) / sizeof(Entry);
+        if (capacity > slots / 2)
+            capacity = slots / 2; // the index stays at most half full
+        if (capacity > perShard)
+            perShard = capacity;
+    }
+    if (perShard == 0)
+        perShard = 1;
+    for (int i = 0; i < shardCount; ++i)
+        shards.push_back(new Shard(perShard));
+}
+
+SolutionCache::~SolutionCache()
+{
+    for (Shard *shard : shards)
+        delete shard;
+}
+
+bool SolutionCache::lookup(const int (&puzzle)[9][9], int (&solution)[9][9])
+{
+    unsigned char record[packedRecordSize];
+    packGrid(puzzle, record);
+    uint64_t hash = hashRecord(record);
+    Shard &shard = shardOf(hash);
+
+    unsigned char packed[packedRecordSize];
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        size_t slot = shard.find(hash);
+        if (shard.index[slot] == 0)
+        {
+            ++shard.stats.misses;
+            return false;
+        }
+
+        uint32_t e = shard.index[slot] - 1;
+        shard.unlink(e);
+        shard.pushNewest(e);
+        memcpy(packed, shard.entries[e].solution, sizeof(packed));
+        ++shard.stats.hits;
+    }
+
+    // a different puzzle with the same hash, counted as the miss it really is
+    int found[9][9];
+    if (!unpackGrid(packed, found) || !validateSolution(puzzle, found))
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        --shard.stats.hits;
+        ++shard.stats.misses;
+        return false;
+    }
+    memcpy(solution, found, sizeof(found));
+    return true;
+}
+
+void SolutionCache::insert(const int (&puzzle)[9][9], const int (&solution)[9][9])
+{
+    unsigned char record[packedRecordSize];
+    packGrid(puzzle, record);
+    uint64_t hash = hashRecord(record);
+    packGrid(solution, record);
+    Shard &shard = shardOf(hash);
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+    size_t slot = shard.find(hash);
+    uint32_t e;
+    if (shard.index[slot] != 0)
+    {
+        // another thread solved the same puzzle first
+        e = shard.index[slot] - 1;
+        shard.unlink(e);
+    }
+    else
+    {
+        if (shard.used < shard.entries.size())
+        {
+            e = shard.used++;
+        }
+        else
+        {
+            // reuse the least recently used entry, taking it out of the index first
+            e = shard.oldest;
+            shard.unlink(e);
+            shard.unindex(shard.find(shard.entries[e].hash));
+            slot = shard.find(hash);
+            ++shard.stats.evictions;
+        }
+        shard.index[slot] = e + 1;
+        shard.entries[e].hash = hash;
+        ++shard.stats.insertions;
+    }
+
+    memcpy(shard.entries[e].solution, record, sizeof(record));
+    shard.pushNewest(e);
+}
+
+CacheStats SolutionCache::stats() const
+{
+    CacheStats total;
+    for (const Shard *shard : shards)
+    {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        CacheStats stats = shard->stats;
+        stats.entries = shard->used;
+        total += stats;
+    }
+    return total;
+}
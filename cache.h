@@ -0,0 +1,72 @@
+// bounded cache of solutions in front of a solver, keyed by the 64 bit hash of the packed puzzle
+// it is split into shards with a lock each so threads solving different puzzles rarely wait on each other,
+// and every shard drops its least recently used solution when it is full
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // For uint32_t/uint64_t
+#include <mutex>
+#include <vector>
+#include "packed.h"
+
+struct CacheStats
+{
+    long hits = 0;
+    long misses = 0;
+    long insertions = 0;
+    long evictions = 0;
+    long entries = 0;  // solutions held right now
+    long capacity = 0; // solutions it can hold
+
+    CacheStats &operator+=(const CacheStats &other)
+    {
+        hits += other.hits;
+        misses += other.misses;
+        insertions += other.insertions;
+        evictions += other.evictions;
+        entries += other.entries;
+        capacity += other.capacity;
+        return *this;
+    }
+};
+
+class SolutionCache
+{
+public:
+    // holds as many solutions as fit in about the given number of bytes
+    explicit SolutionCache(size_t bytes, int shardCount = 16);
+    ~SolutionCache();
+
+    SolutionCache(const SolutionCache &) = delete;
+    SolutionCache &operator=(const SolutionCache &) = delete;
+
+    // fills solution and returns true if the puzzle was cached, solution may be the puzzle itself
+    // a hit is checked against the puzzle before it is used, so two puzzles with the same hash cannot mix up
+    bool lookup(const int (&puzzle)[9][9], int (&solution)[9][9]);
+
+    void insert(const int (&puzzle)[9][9], const int (&solution)[9][9]);
+
+    CacheStats stats() const;
+
+private:
+    // 64 bytes: the key, the links of the recency list and the packed solution
+    struct Entry
+    {
+        uint64_t hash;
+        uint32_t newer, older; // entries either side in the recency list, noEntry at the ends
+        unsigned char solution[packedRecordSize];
+    };
+
+    struct Shard;
+
+    std::vector<Shard *> shards;
+
+    Shard &shardOf(uint64_t hash) const
+    {
+        return *shards[(hash >> 48) % shards.size()];
+    }
+};
+
+#endif
@@ -0,0 +1,373 @@
+// the canonical grid is built a row at a time, keeping every way of building it that is still as small as the best.
+// Rows come from the band being filled (or start a new band), so a candidate tries at most 9 rows at each step.
+// Column orders are not listed out: columns that are blank in every row read so far read the same whichever way
+// round they go, so a candidate keeps them as a tie and only puts them in order when a row tells them apart. In
+// a smallest row blanks come first, so the tied columns are always the first ones of their stack, and the stacks
+// that are blank throughout are the first stacks. Numbers are labelled 1, 2, 3 ... in the order they are first
+// read, which is the smallest labelling for a given order of the cells.
+// Candidates that would read the same rows from here on (same rows used, labels and columns up to ties) are
+// merged, so puzzles with few clues, which tie almost everywhere, stay as cheap as full ones.
+
+#include <vector>
+#include <algorithm> // For std::sort/std::unique/std::next_permutation
+#include <cstring>   // For memcmp
+#include <functional> // For std::less
+#include "canonical.h"
+
+// one way of building the canonical grid that is still as small as the best so far
+struct Candidate
+{
+    int cols[9];    // source column at each position, any order within a tie
+    int tied[3];    // columns at the start of each stack that are blank in every row read so far
+    int tiedStacks; // stacks at the start that are blank throughout, they can go in any order
+    int labels[10]; // 0 for numbers not read yet
+    int nextLabel;
+    int usedRows;   // bit for every source row picked so far
+    bool transpose;
+    int rows[9];    // rows of the source picked so far, left out when merging
+};
+
+// the part of a candidate that decides every row still to come
+bool sameFuture(const Candidate &a, const Candidate &b)
+{
+    return a.transpose == b.transpose && a.usedRows == b.usedRows &&
+           memcmp(a.cols, b.cols, sizeof(a.cols)) == 0 && memcmp(a.labels, b.labels, sizeof(a.labels)) == 0;
+}
+
+bool futureBefore(const Candidate &a, const Candidate &b)
+{
+    if (a.transpose != b.transpose)
+        return a.transpose < b.transpose;
+    if (a.usedRows != b.usedRows)
+        return a.usedRows < b.usedRows;
+    int order = memcmp(a.cols, b.cols, sizeof(a.cols));
+    if (order != 0)
+        return order < 0;
+    return memcmp(a.labels, b.labels, sizeof(a.labels)) < 0;
+}
+
+// insertion sort for the few columns or stacks sorted at a time
+template <typename Less>
+void sortSmall(int *items, int count, Less less)
+{
+    for (int i = 1; i < count; ++i)
+    {
+        int item = items[i], j = i;
+        for (; j > 0 && less(item, items[j - 1]); --j)
+            items[j] = items[j - 1];
+        items[j] = item;
+    }
+}
+
+// candidates of the current and the next row, kept per thread so nothing is allocated once they have grown
+thread_local std::vector<Candidate> current, next;
+
+// runs of columns or stacks in a refined row that read the same but are told apart by the labels new numbers get,
+// every order of a run is a different candidate
+struct Run
+{
+    int start, count, width; // position of the first column, number of items and columns per item
+};
+
+// a row of source read under a candidate, with its ties put in the smallest order
+struct Refinement
+{
+    const int (*source)[9][9];
+    int row;
+    Candidate base;
+    Run runs[16];
+    int runCount;
+};
+
+// sort key of a cell: 0 for a blank, its label if the number was read before and 10 for a number not read yet,
+// new numbers get the labels after every old one so they always go last
+int cellKey(const Candidate &candidate, int value)
+{
+    if (value == 0)
+        return 0;
+    return candidate.labels[value] != 0 ? candidate.labels[value] : 10;
+}
+
+// record every run of equal keys other than blanks among sorted keys, returning how many blanks lead
+// new numbers are all keyed 10, old ones only repeat in a puzzle that breaks the rules
+int addRuns(Refinement &refinement, const int *keys, int start, int count)
+{
+    int blanks = 0;
+    while (blanks < count && keys[blanks] == 0)
+        ++blanks;
+    for (int i = blanks; i < count;)
+    {
+        int end = i + 1;
+        while (end < count && keys[end] == keys[i])
+            ++end;
+        if (end - i > 1)
+            refinement.runs[refinement.runCount++] = Run{start + i, end - i, 1};
+        i = end;
+    }
+    return blanks;
+}
+
+// order the columns at positions [start, start + count) by key, recording the run of new numbers and returning
+// how many blanks lead
+int refineColumns(Refinement &refinement, int start, int count)
+{
+    Candidate &candidate = refinement.base;
+    const int *row = (*refinement.source)[refinement.row];
+    int *cols = candidate.cols + start;
+    sortSmall(cols, count, [&](int a, int b)
+              { int ka = cellKey(candidate, row[a]), kb = cellKey(candidate, row[b]);
+                return ka != kb ? ka < kb : a < b; });
+
+    int keys[9];
+    for (int i = 0; i < count; ++i)
+        keys[i] = cellKey(candidate, row[cols[i]]);
+    return addRuns(refinement, keys, start, count);
+}
+
+// the smallest row the candidate can read from the source row, with its columns in that order
+void refineRow(Refinement &refinement)
+{
+    Candidate &candidate = refinement.base;
+    const int *row = (*refinement.source)[refinement.row];
+    refinement.runCount = 0;
+
+    // stacks blank throughout: sort the columns of each, then the stacks by what they read
+    int stacks = candidate.tiedStacks;
+    if (stacks > 0)
+    {
+        int keys[3][3];
+        int order[3] = {0, 1, 2};
+        int cols[9];
+        for (int s = 0; s < stacks; ++s)
+        {
+            int *stack = candidate.cols + s * 3;
+            sortSmall(stack, 3, [&](int a, int b)
+                      { int ka = cellKey(candidate, row[a]), kb = cellKey(candidate, row[b]);
+                        return ka != kb ? ka < kb : a < b; });
+            for (int i = 0; i < 3; ++i)
+                keys[s][i] = cellKey(candidate, row[stack[i]]);
+        }
+        sortSmall(order, stacks, [&](int a, int b)
+                  { for (int i = 0; i < 3; ++i)
+                        if (keys[a][i] != keys[b][i])
+                            return keys[a][i] < keys[b][i];
+                    return candidate.cols[a * 3] < candidate.cols[b * 3]; });
+        for (int s = 0; s < stacks; ++s)
+            for (int i = 0; i < 3; ++i)
+                cols[s * 3 + i] = candidate.cols[order[s] * 3 + i];
+
+        int stillBlank = 0;
+        for (int s = 0; s < stacks; ++s)
+        {
+            const int *key = keys[order[s]];
+            for (int i = 0; i < 3; ++i)
+                candidate.cols[s * 3 + i] = cols[s * 3 + i];
+            stillBlank += key[2] == 0;
+        }
+
+        // stacks reading the same (but not blank) are told apart only by the labels they hand out
+        for (int s = stillBlank; s < stacks;)
+        {
+            int end = s + 1;
+            while (end < stacks && memcmp(keys[order[end]], keys[order[s]], sizeof(keys[0])) == 0)
+                ++end;
+            if (end - s > 1)
+                refinement.runs[refinement.runCount++] = Run{s * 3, end - s, 3};
+            s = end;
+        }
+
+        // inside every stack that stops being blank, its blanks stay tied and its new numbers make a run
+        for (int s = stillBlank; s < stacks; ++s)
+            candidate.tied[s] = addRuns(refinement, keys[order[s]], s * 3, 3);
+        candidate.tiedStacks = stillBlank;
+    }
+
+    // the tied columns at the start of every other stack
+    for (int s = stacks; s < 3; ++s)
+        if (candidate.tied[s] > 0)
+            candidate.tied[s] = refineColumns(refinement, s * 3, candidate.tied[s]);
+}
+
+// the row the refined candidate reads, with the labels its new numbers get
+void readRow(const Refinement &refinement, Candidate &candidate, int (&line)[9])
+{
+    const int *row = (*refinement.source)[refinement.row];
+    for (int c = 0; c < 9; ++c)
+    {
+        int value = row[candidate.cols[c]];
+        if (value != 0 && candidate.labels[value] == 0)
+            candidate.labels[value] = candidate.nextLabel++;
+        line[c] = candidate.labels[value];
+    }
+}
+
+// put the columns still tied in one order, so candidates that only differ inside their ties can be merged
+void normalizeTies(Candidate &candidate)
+{
+    for (int s = candidate.tiedStacks; s < 3; ++s)
+        sortSmall(candidate.cols + s * 3, candidate.tied[s], std::less<int>());
+
+    int order[3] = {0, 1, 2}, cols[9];
+    for (int s = 0; s < candidate.tiedStacks; ++s)
+        sortSmall(candidate.cols + s * 3, 3, std::less<int>());
+    sortSmall(order, candidate.tiedStacks, [&](int a, int b)
+              { return candidate.cols[a * 3] < candidate.cols[b * 3]; });
+    for (int s = 0; s < candidate.tiedStacks; ++s)
+        for (int i = 0; i < 3; ++i)
+            cols[s * 3 + i] = candidate.cols[order[s] * 3 + i];
+    for (int i = 0; i < candidate.tiedStacks * 3; ++i)
+        candidate.cols[i] = cols[i];
+}
+
+// the best row so far and whether there is one yet
+struct BestRow
+{
+    int line[9];
+    bool found;
+};
+
+// every order of the runs from the given one on, each kept for the next row if it reads no bigger than the best
+// row, starting over when it reads smaller. In a valid puzzle every order reads the same row, only a number
+// repeated in the row makes some orders read bigger.
+void branch(const Refinement &refinement, Candidate &candidate, int run, BestRow &best)
+{
+    if (run == refinement.runCount)
+    {
+        Candidate child = candidate;
+        int line[9];
+        readRow(refinement, child, line);
+
+        int order = best.found ? 0 : -1;
+        for (int c = 0; c < 9 && order == 0; ++c)
+            order = line[c] < best.line[c] ? -1 : line[c] > best.line[c] ? 1 : 0;
+        if (order > 0)
+            return;
+        if (order < 0)
+        {
+            for (int c = 0; c < 9; ++c)
+                best.line[c] = line[c];
+            next.clear();
+            best.found = true;
+        }
+
+        normalizeTies(child);
+        next.push_back(child);
+        return;
+    }
+
+    const Run &r = refinement.runs[run];
+    int original[9], order[3] = {0, 1, 2};
+    for (int i = 0; i < r.count * r.width; ++i)
+        original[i] = candidate.cols[r.start + i];
+    do
+    {
+        for (int item = 0; item < r.count; ++item)
+            for (int i = 0; i < r.width; ++i)
+                candidate.cols[r.start + item * r.width + i] = original[order[item] * r.width + i];
+        branch(refinement, candidate, run + 1, best);
+    } while (std::next_permutation(order, order + r.count));
+
+    for (int i = 0; i < r.count * r.width; ++i)
+        candidate.cols[r.start + i] = original[i];
+}
+
+Transform canonicalForm(const int (&grid)[9][9], int (&canonical)[9][9])
+{
+    int sources[2][9][9];
+    for (int r = 0; r < 9; ++r)
+        for (int c = 0; c < 9; ++c)
+        {
+            sources[0][r][c] = grid[r][c];
+            sources[1][c][r] = grid[r][c];
+        }
+
+    // before the first row every column and every stack is tied
+    current.clear();
+    for (int t = 0; t < 2; ++t)
+    {
+        Candidate start = {{0, 1, 2, 3, 4, 5, 6, 7, 8}, {3, 3, 3}, 3, {}, 1, 0, t == 1, {}};
+        current.push_back(start);
+    }
+
+    // every row, from the band being filled or the first row of a band not used yet
+    for (int depth = 0; depth < 9; ++depth)
+    {
+        BestRow best;
+        best.found = false;
+        next.clear();
+        for (const Candidate &parent : current)
+        {
+            bool newBand = depth % 3 == 0;
+            int band = newBand ? -1 : parent.rows[depth - 1] / 3;
+            for (int row = 0; row < 9; ++row)
+            {
+                if (parent.usedRows >> row & 1 || (row / 3 == band) == newBand)
+                    continue;
+                if (newBand && parent.usedRows >> (row / 3 * 3) & 7)
+                    continue;
+
+                Refinement refinement;
+                refinement.source = &sources[parent.transpose];
+                refinement.row = row;
+                refinement.base = parent;
+                refineRow(refinement);
+                refinement.base.rows[depth] = row;
+                refinement.base.usedRows |= 1 << row;
+                branch(refinement, refinement.base, 0, best);
+            }
+        }
+
+        std::sort(next.begin(), next.end(), futureBefore);
+        next.erase(std::unique(next.begin(), next.end(), sameFuture), next.end());
+        current.swap(next);
+    }
+
+    // any candidate left gives the same grid, numbers missing from the puzzle take the labels left over
+    const Candidate &chosen = current.front();
+    Transform transform;
+    transform.transpose = chosen.transpose;
+    int nextLabel = chosen.nextLabel;
+    for (int value = 0; value < 10; ++value)
+        transform.labels[value] = value != 0 && chosen.labels[value] == 0 ? nextLabel++ : chosen.labels[value];
+    for (int i = 0; i < 9; ++i)
+    {
+        transform.rows[i] = chosen.rows[i];
+        transform.cols[i] = chosen.cols[i];
+    }
+
+    // a rare puzzle can still leave many candidates, don't hold on to the memory they took
+    const size_t keep = 4096;
+    if (current.capacity() > keep)
+        std::vector<Candidate>().swap(current);
+    if (next.capacity() > keep)
+        std::vector<Candidate>().swap(next);
+
+    applyTransform(transform, grid, canonical);
+    return transform;
+}
+
+void applyTransform(const Transform &transform, const int (&grid)[9][9], int (&result)[9][9])
+{
+    for (int r = 0; r < 9; ++r)
+        for (int c = 0; c < 9; ++c)
+        {
+            int row = transform.rows[r], col = transform.cols[c];
+            int value = transform.transpose ? grid[col][row] : grid[row][col];
+            result[r][c] = transform.labels[value];
+        }
+}
+
+void applyInverse(const Transform &transform, const int (&grid)[9][9], int (&result)[9][9])
+{
+    int values[10];
+    for (int value = 0; value < 10; ++value)
+        values[transform.labels[value]] = value;
+
+    for (int r = 0; r < 9; ++r)
+        for (int c = 0; c < 9; ++c)
+        {
+            int row = transform.rows[r], col = transform.cols[c];
+            int &cell = transform.transpose ? result[col][row] : result[row][col];
+            cell = values[grid[r][c]];
+        }
+}
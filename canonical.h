@@ -0,0 +1,26 @@
+// canonical form of a puzzle under the symmetries that keep a sudoku a sudoku: transposing, reordering the bands
+// (and the rows inside each band), reordering the stacks (and the columns inside each stack) and relabelling the
+// numbers. Equivalent puzzles get the same canonical grid, so it can key deduplication and caching, and the
+// transform found on the way maps a solution of the canonical grid back to the original puzzle.
+
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+// canonical[r][c] = labels[source[rows[r]][cols[c]]], where source is the grid, transposed first if asked
+struct Transform
+{
+    bool transpose;
+    int rows[9];
+    int cols[9];
+    int labels[10]; // labels[0] is always 0 so blanks stay blank
+};
+
+// the smallest grid (read row by row, blanks first) among every equivalent form, and the transform that gives it
+Transform canonicalForm(const int (&grid)[9][9], int (&canonical)[9][9]);
+
+void applyTransform(const Transform &transform, const int (&grid)[9][9], int (&result)[9][9]);
+
+// undo a transform, so a solution of the canonical grid becomes a solution of the original
+void applyInverse(const Transform &transform, const int (&grid)[9][9], int (&result)[9][9]);
+
+#endif
@@ -0,0 +1,255 @@
+// generate unique solution puzzles: fill a random grid, then take clues away as long as the solution stays unique
+// every puzzle gets its own random stream worked out from the seed and its index, so the same seed gives the same
+// file however many threads are used
+
+#include <iostream> // Includes the standard input/output stream library
+#include <string>
+#include <vector>
+#include <random>    // For mt19937_64
+#include <algorithm> // For std::shuffle
+#include <cstdint>   // For uint64_t
+#include <cstdlib>   // For atoi/strtoull
+#include <cstring>   // For strncmp
+#include "solvers.h"
+#include "sudoku_io.h"
+#include "thread_pool.h"
+
+const long chunkSize = 256; // puzzles handed to a worker at once
+
+// range of guesses (search nodes with a real choice, see v10::countSolutions) for each difficulty
+struct Difficulty
+{
+    const char *name;
+    long minGuesses, maxGuesses;
+};
+
+const Difficulty difficulties[] = {
+    {"any", 0, -1},
+    {"easy", 0, 0},    // singles alone solve it
+    {"medium", 1, 2},
+    {"hard", 3, 9},
+    {"expert", 10, -1},
+};
+
+struct Options
+{
+    long count = 100;
+    uint64_t seed = 1;
+    int threads = 1;
+    int minClues = 17;
+    const Difficulty *difficulty = &difficulties[0];
+    bool ratings = false;
+    int maxAttempts = 1000; // grids tried for one puzzle before giving up on the difficulty
+};
+
+// splitmix64, used to turn the seed and the puzzle index into well separated seeds
+uint64_t mixSeed(uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// backtracking with the numbers of every cell tried in random order
+bool fillRandom(int (&grid)[9][9], int cell, int (&rowMasks)[9], int (&colMasks)[9], int (&subgridMasks)[9],
+                std::mt19937_64 &rng)
+{
+    if (cell == 81)
+        return true;
+
+    int row = cell / 9, col = cell % 9, subgrid = (row / 3) * 3 + col / 3;
+    int numbers[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    std::shuffle(numbers, numbers + 9, rng);
+
+    for (int num : numbers)
+    {
+        int bit = 1 << (num - 1);
+        if ((rowMasks[row] | colMasks[col] | subgridMasks[subgrid]) & bit)
+            continue;
+
+        grid[row][col] = num;
+        rowMasks[row] |= bit;
+        colMasks[col] |= bit;
+        subgridMasks[subgrid] |= bit;
+
+        if (fillRandom(grid, cell + 1, rowMasks, colMasks, subgridMasks, rng))
+            return true;
+
+        rowMasks[row] &= ~bit;
+        colMasks[col] &= ~bit;
+        subgridMasks[subgrid] &= ~bit;
+    }
+
+    grid[row][col] = 0;
+    return false;
+}
+
+// one minimal (or minClues) puzzle, returns the guesses needed to solve it
+long generatePuzzle(int (&grid)[9][9], int minClues, std::mt19937_64 &rng)
+{
+    int rowMasks[9] = {}, colMasks[9] = {}, subgridMasks[9] = {};
+    fillRandom(grid, 0, rowMasks, colMasks, subgridMasks, rng);
+
+    int order[81];
+    for (int i = 0; i < 81; ++i)
+        order[i] = i;
+    std::shuffle(order, order + 81, rng);
+
+    // the count stops at the second solution, which is all a uniqueness check needs
+    int clues = 81;
+    for (int cell : order)
+    {
+        if (clues <= minClues)
+            break;
+
+        int value = grid[cell / 9][cell % 9];
+        grid[cell / 9][cell % 9] = 0;
+        if (v10::countSolutions(grid, 2) == 1)
+            --clues;
+        else
+            grid[cell / 9][cell % 9] = value;
+    }
+
+    long guesses = 0;
+    v10::countSolutions(grid, 2, &guesses);
+    return guesses;
+}
+
+bool matches(const Difficulty &difficulty, long guesses)
+{
+    return guesses >= difficulty.minGuesses && (difficulty.maxGuesses < 0 || guesses <= difficulty.maxGuesses);
+}
+
+// the puzzles from first up to (not including) last, as the lines to print
+void generateChunk(long first, long last, const Options &options, std::string &output, long &failed)
+{
+    char line[128];
+    for (long index = first; index < last; ++index)
+    {
+        std::mt19937_64 rng(mixSeed(options.seed ^ mixSeed(index)));
+        int grid[9][9];
+        long guesses = 0;
+        bool found = false;
+
+        for (int attempt = 0; attempt < options.maxAttempts && !found; ++attempt)
+        {
+            guesses = generatePuzzle(grid, options.minClues, rng);
+            found = matches(*options.difficulty, guesses);
+        }
+
+        if (!found)
+        {
+            ++failed;
+            continue;
+        }
+
+        for (int i = 0; i < 81; ++i)
+            line[i] = grid[i / 9][i % 9] == 0 ? '.' : static_cast<char>('0' + grid[i / 9][i % 9]);
+        int length = 81;
+        if (options.ratings)
+            length += snprintf(line + 81, sizeof(line) - 81, " %ld", guesses);
+        line[length++] = '\n';
+        output.append(line, length);
+    }
+}
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --count=N          puzzles to generate (default 100)\n"
+              << "  --seed=N           random seed, the same seed gives the same puzzles (default 1)\n"
+              << "  --threads=N        worker threads, 0 for one per core (default 1)\n"
+              << "  --difficulty=NAME  any, easy, medium, hard or expert (default any)\n"
+              << "  --min-clues=N      stop taking clues away at N, more clues make easier puzzles (default 17)\n"
+              << "  --ratings          print the guesses needed to solve each puzzle after it\n"
+              << "Difficulty is the number of search nodes with a real choice when solving with v10:\n"
+              << "easy 0 (singles alone), medium 1-2, hard 3-9, expert 10 or more.\n";
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--count=", 8) == 0)
+            options.count = atol(arg + 8);
+        else if (strncmp(arg, "--seed=", 7) == 0)
+            options.seed = strtoull(arg + 7, nullptr, 10);
+        else if (strncmp(arg, "--threads=", 10) == 0)
+        {
+            options.threads = atoi(arg + 10);
+            if (options.threads <= 0)
+                options.threads = ThreadPool::defaultSize();
+        }
+        else if (strncmp(arg, "--difficulty=", 13) == 0)
+        {
+            options.difficulty = nullptr;
+            for (const Difficulty &difficulty : difficulties)
+                if (strcmp(difficulty.name, arg + 13) == 0)
+                    options.difficulty = &difficulty;
+            if (options.difficulty == nullptr)
+            {
+                std::cerr << "Unknown difficulty " << arg + 13 << "\n";
+                return 1;
+            }
+        }
+        else if (strncmp(arg, "--min-clues=", 12) == 0)
+            options.minClues = atoi(arg + 12);
+        else if (strcmp(arg, "--ratings") == 0)
+            options.ratings = true;
+        else
+        {
+            printUsage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (options.count < 0 || options.minClues < 0 || options.minClues > 81)
+    {
+        std::cerr << "Need a count of 0 or more and a clue count between 0 and 81\n";
+        return 1;
+    }
+
+    ThreadPool pool(options.threads);
+    OutputWriter writer;
+    Timer timer;
+
+    // a round of chunks at a time, written in order once the whole round is done, so memory stays flat
+    const long chunksPerRound = pool.size() * 4;
+    std::vector<std::string> outputs(chunksPerRound);
+    std::vector<long> failures(chunksPerRound);
+    long failed = 0;
+
+    for (long roundStart = 0; roundStart < options.count; roundStart += chunksPerRound * chunkSize)
+    {
+        JobGroup round(pool);
+        for (long c = 0; c < chunksPerRound; ++c)
+        {
+            long first = roundStart + c * chunkSize;
+            long last = std::min(first + chunkSize, options.count);
+            outputs[c].clear();
+            failures[c] = 0;
+            if (first >= last)
+                continue;
+
+            round.submit([&, c, first, last](int)
+                         { generateChunk(first, last, options, outputs[c], failures[c]); });
+        }
+        round.wait();
+
+        for (long c = 0; c < chunksPerRound; ++c)
+        {
+            writer.write(outputs[c].data(), outputs[c].size());
+            failed += failures[c];
+        }
+    }
+    writer.flush();
+
+    std::cerr << "Generated " << options.count - failed << " " << options.difficulty->name << " puzzles in "
+              << timer.elapsedMilliseconds() << " milliseconds on " << pool.size() << " threads\n";
+    if (failed > 0)
+        std::cerr << failed << " puzzles found no grid of that difficulty in " << options.maxAttempts << " tries\n";
+    return 0;
+}
@@ -0,0 +1,10 @@
+// the vector type shared by the code that works on 16 grids at once, one grid per lane (v9 and the batch validator)
+
+#ifndef LANES_H
+#define LANES_H
+
+// 16 lanes of 16 bits, compiled to AVX2 with -mavx2 (make NATIVE=1) and to pairs of SSE2 registers otherwise
+typedef unsigned short Lanes __attribute__((vector_size(32)));
+const int laneCount = 16;
+
+#endif
@@ -0,0 +1,113 @@
+// convert puzzle files between the 81 character text format and the packed binary format of packed.h
+// solution files convert the same way, a full grid is just a puzzle with no blanks
+
+#include <iostream> // Includes the standard input/output stream library
+#include <cstring>  // For strcmp
+#include "sudoku_io.h"
+#include "packed.h"
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--unpack] [FILE|-]\n"
+              << "  FILE      text puzzles to pack, - or nothing for stdin, the packed file goes to stdout\n"
+              << "  --unpack  turn a packed file back into one 81 character line per grid\n";
+}
+
+int pack(PuzzleReader &reader)
+{
+    OutputWriter writer;
+    PackedHeader header = packedHeader();
+    writer.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    int grid[9][9];
+    bool valid;
+    unsigned char record[packedRecordSize];
+    long records = 0;
+
+    while (nextPuzzle(reader, grid, valid))
+    {
+        if (!valid)
+        {
+            writer.flush();
+            std::cerr << "Invalid puzzle on " << reader.lineName() << " " << reader.lineNumber() << "\n";
+            return 1;
+        }
+        packGrid(grid, record);
+        writer.write(reinterpret_cast<const char *>(record), sizeof(record));
+        ++records;
+    }
+    writer.flush();
+
+    std::cerr << "Packed " << records << " grids\n";
+    return 0;
+}
+
+int unpack(PuzzleReader &reader)
+{
+    if (!reader.isPacked())
+    {
+        std::cerr << "Not a packed file\n";
+        return 1;
+    }
+
+    OutputWriter writer;
+    int grid[9][9];
+    bool valid;
+    long records = 0;
+
+    while (nextPuzzle(reader, grid, valid))
+    {
+        if (!valid)
+        {
+            writer.flush();
+            std::cerr << "Invalid grid in record " << reader.lineNumber() << "\n";
+            return 1;
+        }
+        writer.writeGrid(grid);
+        ++records;
+    }
+    writer.flush();
+
+    std::cerr << "Unpacked " << records << " grids\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = "-";
+    bool unpacking = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--unpack") == 0)
+        {
+            unpacking = true;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            printUsage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+        else
+        {
+            path = arg;
+        }
+    }
+
+    PuzzleReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    // packing an already packed file would only copy it
+    if (!unpacking && reader.isPacked())
+    {
+        std::cerr << path << " is already packed\n";
+        return 1;
+    }
+
+    return unpacking ? unpack(reader) : pack(reader);
+}
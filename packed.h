@@ -0,0 +1,93 @@
+// packed binary puzzle files: a 16 byte header, then one 41 byte record per 9x9 grid
+// every cell takes 4 bits (0 for a blank), two cells a byte with the first cell in the low half, so the 81st cell
+// is alone in the low half of the last byte. Records all have the same size, so record i starts at byte
+// 16 + 41 * i and the file needs no separate index: the number of records is worked out from the file size.
+
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // For uint32_t/uint64_t
+#include <cstring> // For memcmp/memcpy
+
+const size_t packedHeaderSize = 16;
+const size_t packedRecordSize = 41;
+const uint32_t packedVersion = 1;
+
+struct PackedHeader
+{
+    char magic[8];       // "SUDOKU41"
+    uint32_t version;    // packedVersion
+    uint32_t recordSize; // packedRecordSize, so a reader can tell a file it does not understand
+};
+
+static_assert(sizeof(PackedHeader) == packedHeaderSize, "the header is written as is");
+
+const char packedMagic[8] = {'S', 'U', 'D', 'O', 'K', 'U', '4', '1'};
+
+inline PackedHeader packedHeader()
+{
+    PackedHeader header;
+    memcpy(header.magic, packedMagic, sizeof(packedMagic));
+    header.version = packedVersion;
+    header.recordSize = packedRecordSize;
+    return header;
+}
+
+// whether the data starts with a header this code can read, only the magic is needed to tell the formats apart
+inline bool isPackedHeader(const char *data, size_t size)
+{
+    if (size < packedHeaderSize || memcmp(data, packedMagic, sizeof(packedMagic)) != 0)
+        return false;
+
+    PackedHeader header;
+    memcpy(&header, data, sizeof(header));
+    return header.version == packedVersion && header.recordSize == packedRecordSize;
+}
+
+inline bool startsPacked(const char *data, size_t size)
+{
+    return size >= sizeof(packedMagic) && memcmp(data, packedMagic, sizeof(packedMagic)) == 0;
+}
+
+inline void packGrid(const int (&grid)[9][9], unsigned char *record)
+{
+    const int *cells = &grid[0][0];
+    for (int i = 0; i < 40; ++i)
+        record[i] = static_cast<unsigned char>(cells[2 * i] | cells[2 * i + 1] << 4);
+    record[40] = static_cast<unsigned char>(cells[80]);
+}
+
+// decode straight into the grid the solvers take, false if a cell holds more than 9
+inline bool unpackGrid(const unsigned char *record, int (&grid)[9][9])
+{
+    int *cells = &grid[0][0];
+    int bad = record[40] >> 4; // the unused half must be 0
+    for (int i = 0; i < 40; ++i)
+    {
+        int low = record[i] & 0xF, high = record[i] >> 4;
+        cells[2 * i] = low;
+        cells[2 * i + 1] = high;
+        bad |= (low > 9) | (high > 9);
+    }
+    cells[80] = record[40] & 0xF;
+    return bad == 0 && cells[80] <= 9;
+}
+
+// 64 bit hash of a record, used to key caches and stores by the packed grid
+// five 8 byte words and the last byte, each mixed in with a multiply and a shift like splitmix64
+inline uint64_t hashRecord(const unsigned char *record)
+{
+    uint64_t hash = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 5; ++i)
+    {
+        uint64_t word;
+        memcpy(&word, record + 8 * i, sizeof(word));
+        hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+    }
+    hash = (hash ^ record[40]) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 29);
+}
+
+#endif
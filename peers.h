@@ -0,0 +1,55 @@
+// the rows, columns and boxes of the board and the peers of every cell, worked out at compile time
+// B is the box size, so B = 3 is the usual 9x9 board, 4 is 16x16 and 5 is 25x25
+
+#ifndef PEERS_H
+#define PEERS_H
+
+template <int B>
+struct PeerTables
+{
+    static constexpr int size = B * B;                                  // numbers, and cells per unit
+    static constexpr int cellCount = size * size;
+    static constexpr int unitCount = 3 * size;
+    static constexpr int peerCount = 2 * (size - 1) + (B - 1) * (B - 1); // 20 on a 9x9 board
+
+    int units[unitCount][size];     // cells of each row, then each column, then each box
+    int cellUnits[cellCount][3];    // row, column and box unit of each cell
+    int peers[cellCount][peerCount]; // cells that share a unit with each cell
+
+    constexpr PeerTables() : units(), cellUnits(), peers()
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            for (int j = 0; j < size; ++j)
+            {
+                units[i][j] = i * size + j;                                             // row i
+                units[size + i][j] = j * size + i;                                      // column i
+                units[2 * size + i][j] = ((i / B) * B + j / B) * size + (i % B) * B + j % B; // box i
+            }
+        }
+
+        for (int cell = 0; cell < cellCount; ++cell)
+        {
+            int row = cell / size, col = cell % size, box = (row / B) * B + col / B;
+            cellUnits[cell][0] = row;
+            cellUnits[cell][1] = size + col;
+            cellUnits[cell][2] = 2 * size + box;
+
+            // the rest of the row and column, then the box cells outside both
+            int count = 0;
+            for (int i = 0; i < size; ++i)
+                if (i != col)
+                    peers[cell][count++] = row * size + i;
+            for (int i = 0; i < size; ++i)
+                if (i != row)
+                    peers[cell][count++] = i * size + col;
+            for (int other : units[2 * size + box])
+                if (other / size != row && other % size != col)
+                    peers[cell][count++] = other;
+        }
+    }
+};
+
+inline constexpr PeerTables<3> peerTables;
+
+#endif
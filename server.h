@@ -0,0 +1,390 @@
+// long running server: puzzles come in one per line over a Unix domain socket (or stdin) and are solved on a pool
+// of worker threads that stays up between requests, so the solvers' per-thread state stays warm
+// a client can send many lines without waiting (as long as it keeps reading its answers, the server only holds a
+// bounded number for each connection), and the answers come back in the order the puzzles were sent:
+//   <81 digit solution> us=<microseconds>   or   none us=<microseconds>   or   invalid
+// builds with make STATS=1 add the search effort of each puzzle, nodes=<n> backtracks=<n>
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <cerrno>   // For EINTR
+#include <csignal>  // For sigaction
+#include <cstdio>   // For snprintf
+#include <cstring>  // For memcpy/memmove/strlen
+#include <deque>
+#include <memory>   // For shared_ptr
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <fcntl.h>      // For fcntl
+#include <poll.h>       // For poll
+#include <sys/socket.h> // For socket/bind/listen/accept
+#include <sys/stat.h>   // For stat
+#include <sys/un.h>     // For sockaddr_un
+#include <unistd.h>     // For pipe/read/write/close/unlink
+#include "solvers.h"
+#include "stats.h"
+#include "sudoku_io.h"
+#include "thread_pool.h"
+
+const size_t maxInFlight = 1024; // answers a connection can have pending before its reader waits
+
+// one puzzle of a connection, answered by a worker and written once every puzzle before it has been
+struct ServerRequest
+{
+    char line[82]; // the first 82 characters are enough to tell whether a line is a puzzle
+    size_t length;
+    char response[160];
+    size_t responseLength = 0;
+    bool done = false;
+};
+
+struct ServerConnection
+{
+    int in, out;
+    std::mutex lock;
+    std::condition_variable ready;      // an answer is done, or the reader has stopped
+    std::condition_variable drained;    // answers have been taken off the queue
+    std::deque<ServerRequest> requests; // oldest first, references stay valid while others are added or removed
+    bool readerDone = false;            // no more requests will come in
+    bool finished = false;              // the reader has stopped and every answer is written
+
+    ServerConnection(int in, int out) : in(in), out(out) {}
+};
+
+// totals over every connection, printed when the server stops
+struct ServerTotals
+{
+    std::atomic<long> requests{0}, solved{0}, connections{0};
+    std::atomic<long long> nanoseconds{0};
+};
+
+inline void writeAllTo(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t count = ::write(fd, data, length);
+        if (count < 0 && errno == EINTR)
+            continue; // a signal, such as the one stopping the server, is not the client hanging up
+        if (count <= 0)
+            return; // the client went away, the rest of its answers are dropped
+        data += count;
+        length -= count;
+    }
+}
+
+// solve one request and format its answer line
+inline void answerRequest(ServerRequest &request, const Solver &solver, ServerTotals &totals)
+{
+    int grid[9][9];
+    if (!parsePuzzle(request.line, request.length, grid))
+    {
+        request.responseLength = snprintf(request.response, sizeof(request.response), "invalid\n");
+        return;
+    }
+
+#ifdef SUDOKU_STATS
+    solverStats = SolverStats();
+#endif
+    Timer timer;
+    bool found = solver.solve(grid);
+    double elapsed = timer.elapsedMilliseconds();
+
+    char *response = request.response;
+    size_t used = 0;
+    if (found)
+    {
+        for (int i = 0; i < 81; ++i)
+            response[i] = static_cast<char>('0' + grid[i / 9][i % 9]);
+        used = 81;
+    }
+    else
+    {
+        used = snprintf(response, sizeof(request.response), "none");
+    }
+    used += snprintf(response + used, sizeof(request.response) - used, " us=%.1f", elapsed * 1000);
+#ifdef SUDOKU_STATS
+    used += snprintf(response + used, sizeof(request.response) - used, " nodes=%llu backtracks=%llu",
+                     solverStats.nodes, solverStats.backtracks);
+#endif
+    response[used++] = '\n';
+    request.responseLength = used;
+
+    ++totals.requests;
+    if (found)
+        ++totals.solved;
+    totals.nanoseconds += static_cast<long long>(elapsed * 1e6);
+}
+
+// queue one line of the connection and hand it to the pool
+inline void submitLine(const std::shared_ptr<ServerConnection> &connection, const char *line, size_t length,
+                       const Solver &solver, ThreadPool &pool, ServerTotals &totals)
+{
+    if (length > 0 && line[length - 1] == '\r')
+        --length;
+    if (length == 0 || line[0] == '#')
+        return;
+
+    ServerRequest *request;
+    {
+        std::unique_lock<std::mutex> guard(connection->lock);
+        connection->drained.wait(guard, [&]
+                                 { return connection->requests.size() < maxInFlight; });
+        connection->requests.emplace_back();
+        request = &connection->requests.back();
+    }
+    request->length = length < sizeof(request->line) ? length : sizeof(request->line);
+    memcpy(request->line, line, request->length);
+
+    pool.submit([connection, request, &solver, &totals](int)
+                {
+        answerRequest(*request, solver, totals);
+
+        std::lock_guard<std::mutex> guard(connection->lock);
+        request->done = true;
+        connection->ready.notify_one(); });
+}
+
+// write the answers in order as they are done, on a thread of the connection's own so a client that reads
+// slowly holds up only itself and never a worker
+inline void writeAnswers(ServerConnection &connection)
+{
+    std::string pending;
+    std::unique_lock<std::mutex> guard(connection.lock);
+    while (true)
+    {
+        connection.ready.wait(guard, [&]
+                              { return connection.requests.empty() ? connection.readerDone
+                                                                   : connection.requests.front().done; });
+        if (connection.requests.empty())
+            return;
+
+        pending.clear();
+        while (!connection.requests.empty() && connection.requests.front().done)
+        {
+            ServerRequest &front = connection.requests.front();
+            pending.append(front.response, front.responseLength);
+            connection.requests.pop_front();
+        }
+        connection.drained.notify_all();
+
+        guard.unlock();
+        writeAllTo(connection.out, pending.data(), pending.size());
+        guard.lock();
+    }
+}
+
+// read lines until the client closes its end, then wait for the last answers to be written
+inline void serveConnection(std::shared_ptr<ServerConnection> connection, const Solver &solver, ThreadPool &pool,
+                            ServerTotals &totals)
+{
+    std::thread writer(writeAnswers, std::ref(*connection));
+
+    char buffer[1 << 16];
+    size_t used = 0;
+    bool skipping = false; // in the middle of a line too long to be a puzzle
+
+    while (true)
+    {
+        ssize_t count = read(connection->in, buffer + used, sizeof(buffer) - used);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            break;
+        used += count;
+
+        size_t start = 0;
+        for (size_t i = 0; i < used; ++i)
+        {
+            if (buffer[i] != '\n')
+                continue;
+            if (!skipping)
+                submitLine(connection, buffer + start, i - start, solver, pool, totals);
+            skipping = false;
+            start = i + 1;
+        }
+
+        // a full buffer without a newline is not a puzzle, answer it once and drop the rest of the line
+        if (start == 0 && used == sizeof(buffer))
+        {
+            if (!skipping)
+                submitLine(connection, buffer, used, solver, pool, totals);
+            skipping = true;
+            start = used;
+        }
+        memmove(buffer, buffer + start, used - start);
+        used -= start;
+    }
+
+    // a last line without a newline
+    if (used > 0 && !skipping)
+        submitLine(connection, buffer, used, solver, pool, totals);
+
+    {
+        std::lock_guard<std::mutex> guard(connection->lock);
+        connection->readerDone = true;
+        connection->ready.notify_one();
+    }
+    writer.join();
+
+    // tell a socket client its last answer is in, the descriptor itself is closed by whoever accepted it
+    shutdown(connection->out, SHUT_WR);
+
+    std::lock_guard<std::mutex> guard(connection->lock);
+    connection->finished = true;
+}
+
+inline void printServerTotals(const ServerTotals &totals)
+{
+    long requests = totals.requests;
+    std::cerr << "Served " << requests << " puzzles (" << totals.solved << " solved) over " << totals.connections
+              << " connections";
+    if (requests > 0)
+        std::cerr << ", " << totals.nanoseconds / 1000.0 / requests << " us solving each on average";
+    std::cerr << "\n";
+}
+
+// set by SIGINT and SIGTERM, the accept loop stops when it sees it
+inline volatile sig_atomic_t serverStopping = 0;
+
+// write end of a pipe the accept loop polls along with the socket, so a signal that lands just before the loop
+// goes back to waiting still wakes it
+inline volatile sig_atomic_t serverWakeFd = -1;
+
+inline void stopServer(int)
+{
+    serverStopping = 1;
+    if (serverWakeFd >= 0)
+    {
+        char byte = 0;
+        ssize_t written = ::write(serverWakeFd, &byte, 1);
+        (void)written;
+    }
+}
+
+// serve over the socket at path until SIGINT or SIGTERM, or over stdin and stdout for "-" until stdin ends
+inline int serve(const char *path, const Solver &solver, ThreadPool &pool)
+{
+    ServerTotals totals;
+    signal(SIGPIPE, SIG_IGN); // a client that hangs up must not take the server down
+
+    if (path[0] == '-' && path[1] == '\0')
+    {
+        ++totals.connections;
+        serveConnection(std::make_shared<ServerConnection>(0, 1), solver, pool, totals);
+        printServerTotals(totals);
+        return 0;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path " << path << " is too long\n";
+        return 1;
+    }
+    strcpy(address.sun_path, path);
+
+    // a socket left behind by an earlier server is replaced, any other file is left alone
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISSOCK(info.st_mode))
+        unlink(path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, 64) != 0)
+    {
+        std::cerr << "Could not listen on " << path << "\n";
+        if (listener >= 0)
+            close(listener);
+        return 1;
+    }
+
+    int wake[2];
+    if (pipe(wake) != 0)
+    {
+        std::cerr << "Could not create a pipe\n";
+        close(listener);
+        return 1;
+    }
+    fcntl(wake[1], F_SETFL, O_NONBLOCK); // a second signal must not block on a full pipe
+    serverWakeFd = wake[1];
+
+    struct sigaction action = {};
+    action.sa_handler = stopServer;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::cerr << "Serving on " << path << " with " << solver.name << " on " << pool.size() << " threads\n";
+
+    std::vector<std::shared_ptr<ServerConnection>> connections;
+    std::vector<std::thread> readers;
+    while (!serverStopping)
+    {
+        pollfd waiting[2] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (poll(waiting, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (waiting[1].revents != 0)
+            break;
+
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        // forget the connections that have finished since the last one came in
+        for (size_t i = 0; i < connections.size();)
+        {
+            bool finished;
+            {
+                std::lock_guard<std::mutex> guard(connections[i]->lock);
+                finished = connections[i]->finished;
+            }
+            if (!finished)
+            {
+                ++i;
+                continue;
+            }
+            readers[i].join();
+            close(connections[i]->in);
+            connections[i] = connections.back();
+            connections.pop_back();
+            readers[i].swap(readers.back());
+            readers.pop_back();
+        }
+
+        ++totals.connections;
+        connections.push_back(std::make_shared<ServerConnection>(client, client));
+        readers.emplace_back(serveConnection, connections.back(), std::cref(solver), std::ref(pool), std::ref(totals));
+    }
+
+    // hang up on the clients still connected, which also frees a writer stuck on a client that stopped reading
+    serverWakeFd = -1;
+    close(wake[0]);
+    close(wake[1]);
+    close(listener);
+    unlink(path);
+    for (auto &connection : connections)
+        shutdown(connection->in, SHUT_RDWR);
+    for (size_t i = 0; i < readers.size(); ++i)
+    {
+        readers[i].join();
+        close(connections[i]->in);
+    }
+
+    printServerTotals(totals);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,28 @@
+// registry of all solver versions
+
+#include <cstring> // For strcmp
+#include "solvers.h"
+
+const Solver solvers[] = {
+    {"v1", "Naive Backtracking", v1::sudokuSolver, nullptr, nullptr},
+    {"v2", "Backtracking + Lists", v2::sudokuSolver, nullptr, nullptr},
+    {"v3", "Backtracking + Bitmasks", v3::sudokuSolver, nullptr, nullptr},
+    {"v4", "LCV/MRV Heuristics", v4::sudokuSolver, nullptr, nullptr},
+    {"v5", "AC-3 Algorithm", v5::sudokuSolver, nullptr, nullptr},
+    {"v6", "AC-3 + Backtracking", v6::sudokuSolver, nullptr, nullptr},
+    {"v7", "Multithreading", v7::sudokuSolver, nullptr, nullptr},
+    {"v8", "Iterative Deepening", v8::sudokuSolver, nullptr, nullptr},
+    {"v9", "SIMD Lockstep Batch", v9::sudokuSolver, v9::solveBatch, nullptr},
+    {"v10", "Dancing Links", v10::sudokuSolver, nullptr, nullptr},
+    {"v11", "Bitboard Propagation + MRV", v11::sudokuSolver, nullptr, v11::solveAnySize},
+};
+
+const size_t solverCount = sizeof(solvers) / sizeof(solvers[0]);
+
+const Solver *findSolver(const char *name)
+{
+    for (size_t i = 0; i < solverCount; ++i)
+        if (strcmp(solvers[i].name, name) == 0)
+            return &solvers[i];
+    return nullptr;
+}
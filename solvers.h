@@ -0,0 +1,110 @@
+// every solver version behind one interface so they can be picked at runtime
+
+#ifndef SOLVERS_H
+#define SOLVERS_H
+
+#include <cstddef>    // For size_t
+#include <cstdint>    // For uint16_t
+#include <functional> // For std::function
+
+class ThreadPool;
+
+// one puzzle, wrapped so grids can be stored in vectors and copied by value
+struct Grid
+{
+    int cells[9][9];
+};
+
+// each version lives in its own namespace with the same entry point
+namespace v1 { bool sudokuSolver(int (&grid)[9][9]); }
+namespace v2 { bool sudokuSolver(int (&grid)[9][9]); }
+namespace v3
+{
+    // masks of the numbers used in each row, column and 3x3 grid for one solve
+    // callers that solve many puzzles can keep one per thread and pass it in
+    struct SolverContext
+    {
+        int rowMasks[9];
+        int colMasks[9];
+        int subgridMasks[9];
+    };
+
+    bool sudokuSolver(int (&grid)[9][9]);
+    bool sudokuSolver(int (&grid)[9][9], SolverContext &context);
+
+    // gets every solution as soon as it is found, returns false to stop the enumeration early
+    // the sink runs inside the search, so a slow sink slows the search down instead of solutions piling up
+    typedef std::function<bool(const int (&grid)[9][9])> SolutionSink;
+
+    // walks every solution of the puzzle with one grid and one set of masks, so memory does not grow with the
+    // number of solutions. Returns how many were handed to the sink, the grid is back to the puzzle afterwards
+    long enumerateSolutions(int (&grid)[9][9], const SolutionSink &sink);
+}
+namespace v4 { bool sudokuSolver(int (&grid)[9][9]); }
+namespace v5
+{
+    // only fills the cells that arc consistency alone can decide
+    bool sudokuSolver(int (&grid)[9][9]);
+
+    // arc consistency over 9 bit domain masks, one per cell, false if a domain runs out
+    // can be run on its own before a search
+    bool ac3(uint16_t (&domains)[81]);
+}
+namespace v6 { bool sudokuSolver(int (&grid)[9][9]); }
+namespace v7 { bool sudokuSolver(int (&grid)[9][9]); }
+namespace v8 { bool sudokuSolver(int (&grid)[9][9]); }
+namespace v9
+{
+    bool sudokuSolver(int (&grid)[9][9]);
+
+    // solves count puzzles in place, solved[i] says whether grids[i] now holds a solution
+    void solveBatch(Grid *grids, bool *solved, size_t count);
+}
+namespace v10
+{
+    bool sudokuSolver(int (&grid)[9][9]);
+
+    // number of solutions, stopping once limit have been found
+    // guesses gets the number of search nodes with more than one way to go, 0 when singles alone solve it
+    long countSolutions(const int (&grid)[9][9], long limit, long *guesses = nullptr);
+}
+namespace v11
+{
+    bool sudokuSolver(int (&grid)[9][9]);
+
+    // board with boxes of B x B, so (B*B) x (B*B) cells stored row by row, 0 for empty
+    // compiled for B = 3, 4 and 5 (9x9, 16x16 and 25x25)
+    template <int B>
+    bool solve(int *cells);
+
+    // picks the compiled size at run time, false for a size that was not compiled
+    bool solveAnySize(int *cells, int boxSize);
+
+    // number of solutions, stopping once limit have been found (limit 2 is a uniqueness check)
+    // given a pool of more than one thread, puzzles with many solutions have their subtrees counted on it
+    // (not from a job running on that pool, the caller waits for the subtrees)
+    template <int B>
+    long countSolutions(const int *cells, long limit, ThreadPool *pool);
+    long countSolutions(const int (&grid)[9][9], long limit, ThreadPool *pool = nullptr);
+}
+
+struct Solver
+{
+    const char *name;        // name used with --solver=
+    const char *description; // one line summary for --list
+    bool (*solve)(int (&grid)[9][9]);
+
+    // engines that work on many puzzles at once, nullptr for the one at a time solvers
+    void (*solveBatch)(Grid *grids, bool *solved, size_t count);
+
+    // engines that also take boards bigger than 9x9, nullptr for the 9x9 only solvers
+    bool (*solveAnySize)(int *cells, int boxSize);
+};
+
+extern const Solver solvers[];
+extern const size_t solverCount;
+
+// look up a solver by name, nullptr if there is no such version
+const Solver *findSolver(const char *name);
+
+#endif
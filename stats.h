@@ -0,0 +1,38 @@
+// search effort counters, these do not depend on the machine so heuristics can be compared by work done
+// they are only compiled in with -DSUDOKU_STATS (make STATS=1), otherwise every STATS_ADD is removed
+
+#ifndef STATS_H
+#define STATS_H
+
+struct SolverStats
+{
+    unsigned long long nodes = 0;        // recursive search calls
+    unsigned long long backtracks = 0;   // placements undone after a dead end
+    unsigned long long propagations = 0; // removeNumberFromLists calls (v2, v4)
+    unsigned long long revisions = 0;    // revise/removeInconsistentValues calls (v5, v6)
+    unsigned long long arcPushes = 0;    // arcs pushed onto the AC-3 queue (v5, v6)
+    unsigned long long restarts = 0;     // discrepancy limit iterations (v8)
+
+    SolverStats &operator+=(const SolverStats &other)
+    {
+        nodes += other.nodes;
+        backtracks += other.backtracks;
+        propagations += other.propagations;
+        revisions += other.revisions;
+        arcPushes += other.arcPushes;
+        restarts += other.restarts;
+        return *this;
+    }
+};
+
+#ifdef SUDOKU_STATS
+// one set of counters per thread so solvers running in parallel do not share cache lines
+inline thread_local SolverStats solverStats;
+#define STATS_ADD(counter, amount) (solverStats.counter += (amount))
+#else
+#define STATS_ADD(counter, amount) ((void)0)
+#endif
+
+#define STATS_INC(counter) STATS_ADD(counter, 1)
+
+#endif
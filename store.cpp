@@ -0,0 +1,159 @@
+// building and reading the on-disk solution store, see store.h for the layout
+
+#include <cstdio>     // For rename
+#include <cstring>    // For memcmp/memcpy
+#include <string>
+#include <fcntl.h>    // For open
+#include <sys/mman.h> // For mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For close/fsync/unlink
+#include "store.h"
+#include "validate.h"
+#include "sudoku_io.h" // For OutputWriter
+
+const char storeMagic[8] = {'S', 'U', 'D', 'O', 'K', 'U', 'S', 'T'};
+const uint32_t storeVersion = 1;
+
+// the slot holding the hash, or the empty slot that ends its probe run
+// a damaged file may have no empty slot, so the probe gives up after going round once
+inline size_t findSlot(const StoreSlot *slots, size_t slotCount, uint64_t hash)
+{
+    size_t mask = slotCount - 1;
+    size_t slot = hash & mask;
+    for (size_t probes = 1; probes < slotCount && slots[slot].record != 0 && slots[slot].hash != hash; ++probes)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+SolutionStore::~SolutionStore()
+{
+    if (mapped != nullptr)
+        munmap(mapped, mappedSize);
+}
+
+bool SolutionStore::open(const char *path)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(StoreHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    // shared, so every process serving from the file uses the same pages of the page cache
+    void *memory = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return false;
+    mapped = memory;
+    mappedSize = info.st_size;
+
+    const StoreHeader *candidate = static_cast<const StoreHeader *>(memory);
+    if (candidate->slotCount > mappedSize / sizeof(StoreSlot) || candidate->recordCount > mappedSize / packedRecordSize)
+        return false;
+    size_t expected = sizeof(StoreHeader) + candidate->slotCount * sizeof(StoreSlot) +
+                      candidate->recordCount * packedRecordSize;
+    if (memcmp(candidate->magic, storeMagic, sizeof(storeMagic)) != 0 || candidate->version != storeVersion ||
+        candidate->recordSize != packedRecordSize || candidate->slotCount == 0 ||
+        (candidate->slotCount & (candidate->slotCount - 1)) != 0 || expected != mappedSize)
+        return false;
+
+    // lookups jump around the index, so read ahead would only fetch pages that are never used
+    madvise(mapped, mappedSize, MADV_RANDOM);
+    header = candidate;
+    slots = reinterpret_cast<const StoreSlot *>(header + 1);
+    records = reinterpret_cast<const unsigned char *>(slots + header->slotCount);
+    return true;
+}
+
+bool SolutionStore::lookup(const int (&puzzle)[9][9], int (&solution)[9][9]) const
+{
+    if (header == nullptr)
+        return false;
+
+    unsigned char record[packedRecordSize];
+    packGrid(puzzle, record);
+    uint64_t hash = hashRecord(record);
+
+    const StoreSlot &slot = slots[findSlot(slots, header->slotCount, hash)];
+    int found[9][9];
+    if (slot.record == 0 || slot.record > header->recordCount ||
+        !unpackGrid(records + (slot.record - 1) * packedRecordSize, found) ||
+        !validateSolution(puzzle, found))
+    {
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    memcpy(solution, found, sizeof(found));
+    hitCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void StoreBuilder::add(const int (&puzzle)[9][9], const int (&solution)[9][9])
+{
+    unsigned char record[packedRecordSize];
+    packGrid(puzzle, record);
+    uint64_t hash = hashRecord(record);
+
+    if (slots.size() < (hashes.size() + 1) * 2)
+    {
+        std::vector<StoreSlot> bigger(slots.empty() ? 1024 : slots.size() * 2, StoreSlot{0, 0});
+        for (size_t i = 0; i < hashes.size(); ++i)
+            bigger[findSlot(bigger.data(), bigger.size(), hashes[i])] = StoreSlot{hashes[i], i + 1};
+        slots.swap(bigger);
+    }
+
+    StoreSlot &slot = slots[findSlot(slots.data(), slots.size(), hash)];
+    if (slot.record != 0)
+        return;
+
+    hashes.push_back(hash);
+    slot = StoreSlot{hash, hashes.size()};
+    packGrid(solution, record);
+    records.insert(records.end(), record, record + packedRecordSize);
+}
+
+bool StoreBuilder::write(const char *path)
+{
+    // written next to the old store and renamed over it, so a server that has the old one mapped keeps reading
+    // the old file and never sees a half written one
+    std::string temporary = std::string(path) + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    // an empty store still gets a table, so lookups always have somewhere to probe
+    if (slots.empty())
+        slots.assign(1024, StoreSlot{0, 0});
+
+    StoreHeader header;
+    memcpy(header.magic, storeMagic, sizeof(storeMagic));
+    header.version = storeVersion;
+    header.recordSize = packedRecordSize;
+    header.slotCount = slots.size();
+    header.recordCount = hashes.size();
+
+    {
+        OutputWriter writer(fd);
+        writer.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        writer.write(reinterpret_cast<const char *>(slots.data()), slots.size() * sizeof(StoreSlot));
+        writer.write(reinterpret_cast<const char *>(records.data()), records.size());
+    }
+
+    struct stat info;
+    bool complete = fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == sizeof(header) +
+                                                 slots.size() * sizeof(StoreSlot) + records.size();
+    complete = fsync(fd) == 0 && complete;
+    close(fd);
+    if (!complete || rename(temporary.c_str(), path) != 0)
+    {
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
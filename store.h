@@ -0,0 +1,95 @@
+// solutions worked out ahead of time and kept on disk, looked up without solving anything
+// the file is a header, an open addressing index of 16 byte slots (hash and record number, linear probing, at most
+// half full) and then the packed 41 byte solutions. It is mapped read only, so opening it reads nothing up front
+// and every process serving from the same file shares its pages.
+
+#ifndef STORE_H
+#define STORE_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // For uint32_t/uint64_t
+#include <atomic>
+#include <vector>
+#include "packed.h"
+
+struct StoreHeader
+{
+    char magic[8];        // "SUDOKUST"
+    uint32_t version;     // storeVersion
+    uint32_t recordSize;  // packedRecordSize
+    uint64_t slotCount;   // a power of two
+    uint64_t recordCount;
+};
+
+static_assert(sizeof(StoreHeader) == 32, "the header is written as is");
+
+// one index slot, record is the record number + 1 and 0 for an empty slot
+struct StoreSlot
+{
+    uint64_t hash;
+    uint64_t record;
+};
+
+// read side, safe to share between threads
+class SolutionStore
+{
+public:
+    SolutionStore() {}
+    ~SolutionStore();
+
+    SolutionStore(const SolutionStore &) = delete;
+    SolutionStore &operator=(const SolutionStore &) = delete;
+
+    // false if the file cannot be mapped or is not a store
+    bool open(const char *path);
+
+    // fills solution and returns true if the puzzle is in the store, solution may be the puzzle itself
+    // the stored solution is checked against the puzzle, so two puzzles with the same hash cannot mix up
+    bool lookup(const int (&puzzle)[9][9], int (&solution)[9][9]) const;
+
+    size_t size() const
+    {
+        return header == nullptr ? 0 : header->recordCount;
+    }
+
+    long hits() const
+    {
+        return hitCount;
+    }
+
+    long misses() const
+    {
+        return missCount;
+    }
+
+private:
+    void *mapped = nullptr;
+    size_t mappedSize = 0;
+    const StoreHeader *header = nullptr;
+    const StoreSlot *slots = nullptr;
+    const unsigned char *records = nullptr;
+    mutable std::atomic<long> hitCount{0}, missCount{0};
+};
+
+// write side, collects solutions in memory and writes the whole file at the end
+class StoreBuilder
+{
+public:
+    // a puzzle that is already in the store keeps its first solution
+    void add(const int (&puzzle)[9][9], const int (&solution)[9][9]);
+
+    // writes path.tmp and renames it over path, so readers of the old file are never disturbed
+    bool write(const char *path);
+
+    size_t size() const
+    {
+        return hashes.size();
+    }
+
+private:
+    std::vector<uint64_t> hashes;
+    std::vector<unsigned char> records;
+    std::vector<StoreSlot> slots; // rebuilt twice as big whenever it gets half full
+};
+
+#endif
@@ -0,0 +1,580 @@
+// single driver for every solver version, pick one with --solver=vN
+
+#include <iostream> // Includes the standard input/output stream library
+#include <cstring>  // For strncmp
+#include <cstdlib>  // For atoi
+#include <cstdio>   // For snprintf
+#include <climits>  // For LONG_MAX
+#include <memory>   // For unique_ptr
+#include "solvers.h"
+#include "stats.h"
+#include "sudoku_io.h"
+#include "batch.h"
+#include "canonical.h"
+#include "cache.h"
+#include "store.h"
+#include "server.h"
+
+// the per-version binaries (make v1 ... make v8) are this driver with a different default
+#ifndef DEFAULT_SOLVER
+#define DEFAULT_SOLVER "v3"
+#endif
+
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--solver=NAME] [--list] [--threads=N] [--count[=LIMIT]] [--enumerate[=LIMIT]] [--validate] [--canonical] [--cache=MB] [--store=FILE] [--build-store=FILE] [--serve=PATH] [--stats] [FILE|-]\n"
+              << "  --solver=NAME  solver version to run (default " << DEFAULT_SOLVER << ")\n"
+              << "  --list         list the available solvers\n"
+              << "  --threads=N    solve the file on N worker threads, 0 for one per core (default 1)\n"
+              << "  --count[=N]    print how many solutions each puzzle has instead, counting stops at N\n"
+              << "                 (default 2, enough to tell unique puzzles apart, 0 for no limit)\n"
+              << "                 counting always uses v11 and --threads spreads the puzzles over the threads,\n"
+              << "                 or with N above 2 splits each puzzle's search over them\n"
+              << "  --enumerate[=N] print every solution of each puzzle (up to N), then a '# K solutions' line\n"
+              << "                 enumerating always uses v3\n"
+              << "  --validate     check every 9x9 answer against its puzzle before writing it, wrong answers\n"
+              << "                 are written as 'Invalid solution!' and make the exit status 1\n"
+              << "  --canonical    print the canonical form of each puzzle instead, equivalent puzzles (relabelled,\n"
+              << "                 transposed, rows or columns swapped) print the same line\n"
+              << "  --cache=MB     keep up to MB megabytes of solutions and answer repeated puzzles from them\n"
+              << "  --store=FILE   answer puzzles found in a store file without solving, solve the rest\n"
+              << "  --build-store=FILE  solve every puzzle in the input and write the solutions to a store file\n"
+              << "  --serve=PATH   keep running and solve puzzles sent one per line to the Unix socket at PATH\n"
+              << "                 (- for stdin), answering each with its solution and solve time\n"
+              << "  --stats        print search effort counters (needs make STATS=1)\n"
+              << "  FILE           file with one 81 character puzzle per line or a packed file, - for stdin\n"
+              << "Without a file the built in example puzzle is solved and printed.\n";
+}
+
+// solve the example puzzle and print it the same way the original per-version programs did
+int solveExample(const Solver &solver)
+{
+    // Unsolved Sudoku puzzle (0 represents empty cells)
+    int sudoku[9][9] = {
+        {5, 3, 0, 0, 7, 0, 0, 0, 0},
+        {6, 0, 0, 1, 9, 5, 0, 0, 0},
+        {0, 9, 8, 0, 0, 0, 0, 6, 0},
+        {8, 0, 0, 0, 6, 0, 0, 0, 3},
+        {4, 0, 0, 8, 0, 3, 0, 0, 1},
+        {7, 0, 0, 0, 2, 0, 0, 0, 6},
+        {0, 6, 0, 0, 0, 0, 2, 8, 0},
+        {0, 0, 0, 4, 1, 9, 0, 0, 5},
+        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
+
+    Timer timer;
+    bool solved = solver.solve(sudoku);
+    double elapsed = timer.elapsedMilliseconds();
+
+    // Output the time taken in milliseconds
+    std::cout << "Execution time: " << elapsed << " milliseconds\n"
+              << std::endl;
+
+    // output solved sudoku if it was solved
+    if (solved)
+    {
+        for (int row = 0; row < 9; ++row)
+        {
+            for (int col = 0; col < 9; ++col)
+            {
+                std::cout << sudoku[row][col] << ", ";
+            }
+            std::cout << "\n";
+        }
+    }
+    else
+    {
+        std::cout << "No solution found!\n";
+    }
+
+    return 0;
+}
+
+// --store and --cache go in front of the chosen solver, which is run through a Solver entry of its own
+// a puzzle is looked up in the store, then in the cache, and only solved if neither has it
+const SolutionStore *solutionStore = nullptr;
+SolutionCache *solutionCache = nullptr;
+const Solver *uncachedSolver = nullptr;
+
+bool solveCached(int (&grid)[9][9])
+{
+    if (solutionStore && solutionStore->lookup(grid, grid))
+        return true;
+    if (solutionCache && solutionCache->lookup(grid, grid))
+        return true;
+
+    int puzzle[9][9];
+    memcpy(puzzle, grid, sizeof(puzzle));
+    if (!uncachedSolver->solve(grid))
+        return false;
+    if (solutionCache)
+        solutionCache->insert(puzzle, grid);
+    return true;
+}
+
+// solve every puzzle in the file on the pool and write the solutions to a store file
+// a round of chunks is solved at a time, so only the solutions stay in memory
+int buildStore(const char *path, const char *storePath, const Solver &solver, ThreadPool &pool)
+{
+    PuzzleReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    StoreBuilder builder;
+    std::vector<BatchChunk> chunks(pool.size() * 2);
+    long puzzles = 0, unsolved = 0;
+    bool moreInput = true, valid;
+    Grid grid;
+
+    Timer timer;
+
+    while (moreInput)
+    {
+        JobGroup round(pool);
+        for (BatchChunk &chunk : chunks)
+        {
+            chunk.grids.clear();
+            while (moreInput && chunk.grids.size() < batchChunkSize)
+            {
+                if (!nextPuzzle(reader, grid.cells, valid))
+                {
+                    moreInput = false;
+                    break;
+                }
+                if (!valid)
+                {
+                    std::cerr << "Invalid puzzle on " << reader.lineName() << " " << reader.lineNumber() << "\n";
+                    moreInput = false;
+                    unsolved = -1;
+                    break;
+                }
+                chunk.grids.push_back(grid);
+            }
+            if (chunk.grids.empty())
+                continue;
+
+            // validating keeps the puzzles next to their solutions, and keeps wrong answers out of the store
+            round.submit([&](int)
+                         { solveChunk(chunk, solver, true); });
+        }
+        round.wait();
+        if (unsolved < 0)
+            return 1;
+
+        for (BatchChunk &chunk : chunks)
+        {
+            for (size_t n = 0; n < chunk.grids.size(); ++n)
+            {
+                if (chunk.found[n] && chunk.valid[n])
+                    builder.add(chunk.puzzles[n].cells, chunk.grids[n].cells);
+                else
+                    ++unsolved;
+            }
+            puzzles += chunk.grids.size();
+            chunk.grids.clear();
+        }
+    }
+
+    if (!builder.write(storePath))
+    {
+        std::cerr << "Could not write " << storePath << "\n";
+        return 1;
+    }
+
+    std::cerr << "Stored " << builder.size() << " solutions of " << puzzles << " puzzles (" << unsolved
+              << " not solved) in " << timer.elapsedMilliseconds() << " milliseconds\n";
+    return 0;
+}
+
+// a run of consecutive puzzles to count and their counts
+struct CountChunk
+{
+    std::vector<Grid> grids;
+    long counts[batchChunkSize];
+};
+
+// count the solutions of every puzzle in the file, written one number per line in input order
+// a uniqueness check takes microseconds, so the workers take a chunk of puzzles each; with a higher limit one
+// puzzle can take far longer than the rest, so puzzles go one at a time with the tree of each split over the pool
+int countStream(const char *path, long limit, ThreadPool &pool)
+{
+    PuzzleReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    OutputWriter writer;
+    std::vector<CountChunk> chunks(pool.size() * 2);
+    const bool splitTrees = limit > 2 && pool.size() > 1;
+    long puzzles = 0, unique = 0, none = 0, invalidLine = 0;
+    bool moreInput = true, valid;
+    Grid grid;
+    char number[32];
+
+    Timer timer;
+
+    while (moreInput)
+    {
+        JobGroup round(pool);
+        for (CountChunk &chunk : chunks)
+        {
+            chunk.grids.clear();
+            while (moreInput && chunk.grids.size() < batchChunkSize)
+            {
+                if (!nextPuzzle(reader, grid.cells, valid))
+                {
+                    moreInput = false;
+                }
+                else if (!valid)
+                {
+                    invalidLine = reader.lineNumber();
+                    moreInput = false;
+                }
+                else
+                {
+                    chunk.grids.push_back(grid);
+                }
+            }
+
+            if (splitTrees)
+            {
+                for (size_t n = 0; n < chunk.grids.size(); ++n)
+                    chunk.counts[n] = v11::countSolutions(chunk.grids[n].cells, limit, &pool);
+            }
+            else if (!chunk.grids.empty())
+            {
+                round.submit([&chunk, limit](int)
+                             {
+                    for (size_t n = 0; n < chunk.grids.size(); ++n)
+                        chunk.counts[n] = v11::countSolutions(chunk.grids[n].cells, limit); });
+            }
+        }
+        round.wait();
+
+        for (CountChunk &chunk : chunks)
+            for (size_t n = 0; n < chunk.grids.size(); ++n)
+            {
+                long count = chunk.counts[n];
+                if (count == 1)
+                    ++unique;
+                else if (count == 0)
+                    ++none;
+                ++puzzles;
+                writer.write(number, snprintf(number, sizeof(number), "%ld\n", count));
+            }
+    }
+    writer.flush();
+
+    if (invalidLine != 0)
+    {
+        std::cerr << "Invalid puzzle on " << reader.lineName() << " " << invalidLine << "\n";
+        return 1;
+    }
+
+    std::cerr << "Counted " << puzzles << " puzzles in " << timer.elapsedMilliseconds() << " milliseconds on "
+              << pool.size() << " threads: " << unique << " unique, " << none << " with no solution, "
+              << puzzles - unique - none << " with more than one\n";
+    return 0;
+}
+
+// write every solution of every puzzle as it is found, each puzzle ends with a '# K solutions' comment line
+// so the output can be read back as a puzzle file
+int enumerateStream(const char *path, long limit)
+{
+    PuzzleReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    OutputWriter writer;
+    int grid[9][9];
+    bool valid;
+    long puzzles = 0, total = 0;
+    char summary[64];
+
+    Timer timer;
+
+    while (nextPuzzle(reader, grid, valid))
+    {
+        if (!valid)
+        {
+            writer.flush();
+            std::cerr << "Invalid puzzle on " << reader.lineName() << " " << reader.lineNumber() << "\n";
+            return 1;
+        }
+
+        // the writer flushes whenever its buffer fills, so the search waits on the output instead of queueing
+        long written = 0;
+        long found = v3::enumerateSolutions(grid, [&](const int (&solution)[9][9])
+                                            {
+            writer.writeGrid(solution);
+            return ++written < limit; });
+
+        ++puzzles;
+        total += found;
+        writer.write(summary, snprintf(summary, sizeof(summary), "# %ld solutions\n", found));
+    }
+    writer.flush();
+
+    std::cerr << "Enumerated " << total << " solutions of " << puzzles << " puzzles in " << timer.elapsedMilliseconds()
+              << " milliseconds\n";
+    return 0;
+}
+
+// write the canonical form of every puzzle, so sort -u on the output removes equivalent puzzles
+int canonicalStream(const char *path)
+{
+    PuzzleReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    OutputWriter writer;
+    int grid[9][9], canonical[9][9];
+    bool valid;
+    long puzzles = 0;
+
+    Timer timer;
+
+    while (nextPuzzle(reader, grid, valid))
+    {
+        if (!valid)
+        {
+            writer.flush();
+            std::cerr << "Invalid puzzle on " << reader.lineName() << " " << reader.lineNumber() << "\n";
+            return 1;
+        }
+
+        canonicalForm(grid, canonical);
+        writer.writeGrid(canonical);
+        ++puzzles;
+    }
+    writer.flush();
+
+    std::cerr << "Canonicalized " << puzzles << " puzzles in " << timer.elapsedMilliseconds() << " milliseconds\n";
+    return 0;
+}
+
+#ifdef SUDOKU_STATS
+void printStats(const SolverStats &stats)
+{
+    std::cerr << "nodes: " << stats.nodes << "\n"
+              << "backtracks: " << stats.backtracks << "\n"
+              << "propagations: " << stats.propagations << "\n"
+              << "revisions: " << stats.revisions << "\n"
+              << "arc pushes: " << stats.arcPushes << "\n"
+              << "restarts: " << stats.restarts << "\n";
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    const char *solverName = DEFAULT_SOLVER;
+    const char *path = nullptr;
+    bool showStats = false;
+    int threads = 1;
+    long countLimit = 0;     // 0 solves instead of counting
+    long enumerateLimit = 0; // 0 solves instead of enumerating
+    bool validate = false;
+    bool canonical = false;
+    long cacheMegabytes = 0;
+    const char *storePath = nullptr;
+    const char *buildStorePath = nullptr;
+    const char *servePath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--solver=", 9) == 0)
+        {
+            solverName = arg + 9;
+        }
+        else if (strcmp(arg, "--list") == 0)
+        {
+            for (size_t s = 0; s < solverCount; ++s)
+                std::cout << solvers[s].name << "\t" << solvers[s].description << "\n";
+            return 0;
+        }
+        else if (strncmp(arg, "--threads=", 10) == 0)
+        {
+            threads = atoi(arg + 10);
+            if (threads <= 0)
+                threads = ThreadPool::defaultSize();
+        }
+        else if (strcmp(arg, "--count") == 0)
+        {
+            countLimit = 2;
+        }
+        else if (strncmp(arg, "--count=", 8) == 0)
+        {
+            countLimit = atol(arg + 8);
+            if (countLimit <= 0)
+                countLimit = LONG_MAX;
+        }
+        else if (strcmp(arg, "--enumerate") == 0)
+        {
+            enumerateLimit = LONG_MAX;
+        }
+        else if (strncmp(arg, "--enumerate=", 12) == 0)
+        {
+            enumerateLimit = atol(arg + 12);
+            if (enumerateLimit <= 0)
+                enumerateLimit = LONG_MAX;
+        }
+        else if (strcmp(arg, "--validate") == 0)
+        {
+            validate = true;
+        }
+        else if (strcmp(arg, "--canonical") == 0)
+        {
+            canonical = true;
+        }
+        else if (strncmp(arg, "--cache=", 8) == 0)
+        {
+            cacheMegabytes = atol(arg + 8);
+        }
+        else if (strncmp(arg, "--store=", 8) == 0)
+        {
+            storePath = arg + 8;
+        }
+        else if (strncmp(arg, "--build-store=", 14) == 0)
+        {
+            buildStorePath = arg + 14;
+        }
+        else if (strncmp(arg, "--serve=", 8) == 0)
+        {
+            servePath = arg + 8;
+        }
+        else if (strcmp(arg, "--stats") == 0)
+        {
+            showStats = true;
+        }
+        else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            path = arg;
+        }
+    }
+
+    const Solver *solver = findSolver(solverName);
+    if (solver == nullptr)
+    {
+        std::cerr << "Unknown solver " << solverName << " (see --list)\n";
+        return 1;
+    }
+
+#ifndef SUDOKU_STATS
+    if (showStats)
+    {
+        std::cerr << "This build has no search counters, rebuild with make clean && make STATS=1\n";
+        return 1;
+    }
+#endif
+
+    if ((countLimit > 0 || enumerateLimit > 0 || canonical || buildStorePath) && path == nullptr)
+    {
+        std::cerr << "--count, --enumerate, --canonical and --build-store need a file of puzzles\n";
+        return 1;
+    }
+
+    if (buildStorePath)
+    {
+        ThreadPool pool(threads);
+        return buildStore(path, buildStorePath, *solver, pool);
+    }
+
+    SolutionStore store;
+    if (storePath)
+    {
+        if (!store.open(storePath))
+        {
+            std::cerr << "Could not open the store " << storePath << "\n";
+            return 1;
+        }
+        solutionStore = &store;
+    }
+
+    // a cached solver goes one puzzle at a time, even a batch solver, so every puzzle can be looked up
+    Solver cachedSolver;
+    std::unique_ptr<SolutionCache> cache;
+    if (cacheMegabytes > 0)
+    {
+        cache.reset(new SolutionCache(cacheMegabytes << 20));
+        solutionCache = cache.get();
+    }
+    if (solutionStore || solutionCache)
+    {
+        uncachedSolver = solver;
+        cachedSolver = {solver->name, solver->description, solveCached, nullptr, solver->solveAnySize};
+        solver = &cachedSolver;
+    }
+
+    int status;
+    if (servePath)
+    {
+        ThreadPool pool(threads);
+        status = serve(servePath, *solver, pool);
+    }
+    else if (countLimit > 0)
+    {
+        ThreadPool pool(threads);
+        status = countStream(path, countLimit, pool);
+    }
+    else if (enumerateLimit > 0)
+    {
+        status = enumerateStream(path, enumerateLimit);
+    }
+    else if (canonical)
+    {
+        status = canonicalStream(path);
+    }
+    else if (path == nullptr)
+    {
+        status = solveExample(*solver);
+    }
+    else if (threads > 1 || solver->solveBatch)
+    {
+        // batch solvers always go through the chunked path, even on one thread
+        ThreadPool pool(threads);
+        status = solveStreamParallel(path, *solver, pool, validate);
+    }
+    else
+    {
+        status = solveStream(path, *solver, validate);
+    }
+
+    if (storePath)
+        std::cerr << "Store: " << store.hits() << " hits, " << store.misses() << " misses, " << store.size()
+                  << " solutions stored\n";
+    if (cache)
+    {
+        CacheStats stats = cache->stats();
+        std::cerr << "Cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions
+                  << " evictions, " << stats.entries << " of " << stats.capacity << " solutions held\n";
+    }
+
+#ifdef SUDOKU_STATS
+    if (showStats)
+        printStats(solverStats);
+#endif
+
+    return status;
+}
@@ -0,0 +1,483 @@
+// shared input/output for running a solver over files with many puzzles
+// puzzles are one per line in the common 81 character format ('.' or '0' for blanks)
+// 16x16 and 25x25 puzzles are 256 and 625 character lines, with 'A' for 10, 'B' for 11 and so on
+// 9x9 puzzles can also come as a packed binary file (see packed.h), which is told apart by its header
+
+#ifndef SUDOKU_IO_H
+#define SUDOKU_IO_H
+
+#include <iostream>   // For error messages
+#include <chrono>     // For timing
+#include <cstddef>    // For size_t
+#include <cstring>    // For memchr/memmove/memcpy
+#include <fcntl.h>    // For open
+#include <sys/mman.h> // For mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For read/write/close
+#include "solvers.h"  // For Grid
+#include "validate.h" // For validateSolution
+#include "packed.h"
+
+// Reads puzzle lines from a file (mapped into memory) or from stdin (read in large chunks)
+// Lines are handed out as pointers into the buffer so nothing is allocated per puzzle
+// A packed file hands out its 41 byte records the same way instead, see nextRecord
+class PuzzleReader
+{
+public:
+    PuzzleReader() {}
+    PuzzleReader(const PuzzleReader &) = delete;
+    PuzzleReader &operator=(const PuzzleReader &) = delete;
+
+    ~PuzzleReader()
+    {
+        if (mapped != nullptr)
+            munmap(mapped, mappedSize);
+        delete[] buffer;
+        if (fd > 0)
+            close(fd);
+    }
+
+    // open a file, or stdin when the path is "-"
+    bool open(const char *path)
+    {
+        if (path[0] == '-' && path[1] == '\0')
+            fd = 0;
+        else
+            fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        // regular files are mapped so the whole input is one buffer
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+        {
+            if (info.st_size == 0)
+            {
+                atEnd = true;
+                return true;
+            }
+
+            void *memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (memory != MAP_FAILED)
+            {
+                mapped = static_cast<char *>(memory);
+                mappedSize = info.st_size;
+                madvise(mapped, mappedSize, MADV_SEQUENTIAL);
+                cursor = mapped;
+                end = mapped + mappedSize;
+                atEnd = true; // nothing left to read after the mapping
+                return checkPacked();
+            }
+        }
+
+        // pipes and terminals fall back to chunked reads
+        capacity = 1 << 20;
+        buffer = new char[capacity];
+        cursor = end = buffer;
+
+        // enough of the input to see whether it starts with a packed header
+        while (!atEnd && end - cursor < static_cast<long>(packedHeaderSize))
+            refill();
+        return checkPacked();
+    }
+
+    // whether the input is a packed file, read with nextRecord instead of nextLine
+    bool isPacked() const
+    {
+        return packed;
+    }
+
+    // hand out the next packed record, the record points into the mapping or buffer like a line does
+    bool nextRecord(const unsigned char *&record)
+    {
+        while (static_cast<size_t>(end - cursor) < packedRecordSize)
+        {
+            if (!atEnd)
+            {
+                refill();
+                continue;
+            }
+            if (cursor == end)
+                return false;
+
+            // a cut off last record is padded with cells that cannot unpack, so it shows up as invalid
+            memset(lastRecord, 0xFF, sizeof(lastRecord));
+            memcpy(lastRecord, cursor, end - cursor);
+            cursor = end;
+            record = lastRecord;
+            ++lineCount;
+            return true;
+        }
+
+        record = reinterpret_cast<const unsigned char *>(cursor);
+        cursor += packedRecordSize;
+        ++lineCount;
+        return true;
+    }
+
+    // hand out the next non-empty line that is not a '#' comment
+    bool nextLine(const char *&line, size_t &length)
+    {
+        while (true)
+        {
+            const char *newline = cursor == end ? nullptr : static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+
+            if (newline == nullptr)
+            {
+                // no full line in the buffer, so pull in more input before giving up
+                if (!atEnd)
+                {
+                    refill();
+                    continue;
+                }
+
+                // last line without a trailing newline
+                if (cursor == end)
+                    return false;
+                newline = end;
+            }
+
+            line = cursor;
+            length = newline - cursor;
+            cursor = newline < end ? newline + 1 : end;
+            ++lineCount;
+
+            // trim a windows line ending
+            if (length > 0 && line[length - 1] == '\r')
+                --length;
+
+            if (length > 0 && line[0] != '#')
+                return true;
+        }
+    }
+
+    // 1-based number of the last line or record handed out
+    long lineNumber() const
+    {
+        return lineCount;
+    }
+
+    // what lineNumber counts, for error messages
+    const char *lineName() const
+    {
+        return packed ? "record" : "line";
+    }
+
+private:
+    int fd = -1;
+    char *mapped = nullptr;
+    size_t mappedSize = 0;
+    char *buffer = nullptr;
+    size_t capacity = 0;
+    const char *cursor = nullptr;
+    const char *end = nullptr;
+    bool atEnd = false;
+    long lineCount = 0;
+    bool packed = false;
+    unsigned char lastRecord[packedRecordSize];
+
+    // skip the header of a packed file, false for a packed file of a version this code cannot read
+    bool checkPacked()
+    {
+        if (!startsPacked(cursor, end - cursor))
+            return true;
+        if (!isPackedHeader(cursor, end - cursor))
+            return false;
+        packed = true;
+        cursor += packedHeaderSize;
+        return true;
+    }
+
+    void refill()
+    {
+        // move the partial line to the front of the buffer
+        size_t leftover = end - cursor;
+        memmove(buffer, cursor, leftover);
+
+        // a single line longer than the buffer, grow it
+        if (leftover == capacity)
+        {
+            char *bigger = new char[capacity * 2];
+            memcpy(bigger, buffer, leftover);
+            delete[] buffer;
+            buffer = bigger;
+            capacity *= 2;
+        }
+
+        ssize_t count = read(fd, buffer + leftover, capacity - leftover);
+        if (count <= 0)
+            atEnd = true;
+
+        cursor = buffer;
+        end = buffer + leftover + (count > 0 ? count : 0);
+    }
+};
+
+// parse one puzzle line into the grid, anything after the first 81 cells must be separated by whitespace or a comma
+inline bool parsePuzzle(const char *line, size_t length, int (&grid)[9][9])
+{
+    if (length < 81)
+        return false;
+    if (length > 81 && line[81] != ' ' && line[81] != '\t' && line[81] != ',' && line[81] != ';')
+        return false;
+
+    for (int i = 0; i < 81; ++i)
+    {
+        char c = line[i];
+        if (c >= '1' && c <= '9')
+            grid[i / 9][i % 9] = c - '0';
+        else if (c == '.' || c == '0')
+            grid[i / 9][i % 9] = 0;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+// next 9x9 puzzle from a text or packed file, false at the end of the input
+// valid is false for a line or record that does not hold a puzzle
+inline bool nextPuzzle(PuzzleReader &reader, int (&grid)[9][9], bool &valid)
+{
+    if (reader.isPacked())
+    {
+        const unsigned char *record;
+        if (!reader.nextRecord(record))
+            return false;
+        valid = unpackGrid(record, grid);
+        return true;
+    }
+
+    const char *line;
+    size_t length;
+    if (!reader.nextLine(line, length))
+        return false;
+    valid = parsePuzzle(line, length, grid);
+    return true;
+}
+
+// number of cells on the line, everything up to the first separator
+inline size_t puzzleLength(const char *line, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+        if (line[i] == ' ' || line[i] == '\t' || line[i] == ',' || line[i] == ';')
+            return i;
+    return length;
+}
+
+// value of one cell of a board of any size, 0 for a blank and -1 for anything else
+inline int cellValue(char c)
+{
+    if (c == '.' || c == '0')
+        return 0;
+    if (c >= '1' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 10;
+    return -1;
+}
+
+inline char cellChar(int value)
+{
+    return static_cast<char>(value < 10 ? '0' + value : 'A' + value - 10);
+}
+
+// parse a line of count cells with numbers up to maxValue, for the boards bigger than 9x9
+inline bool parseCells(const char *line, size_t length, int *cells, int count, int maxValue)
+{
+    if (puzzleLength(line, length) != static_cast<size_t>(count))
+        return false;
+
+    for (int i = 0; i < count; ++i)
+    {
+        cells[i] = cellValue(line[i]);
+        if (cells[i] < 0 || cells[i] > maxValue)
+            return false;
+    }
+
+    return true;
+}
+
+// Buffered writer for stdout (or any file descriptor), flushed in large blocks
+class OutputWriter
+{
+public:
+    explicit OutputWriter(int fd = 1) : fd(fd) {}
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter &operator=(const OutputWriter &) = delete;
+
+    ~OutputWriter()
+    {
+        flush();
+    }
+
+    void write(const char *data, size_t length)
+    {
+        if (used + length > sizeof(buffer))
+        {
+            flush();
+
+            // too big to be worth buffering
+            if (length > sizeof(buffer))
+            {
+                writeAll(data, length);
+                return;
+            }
+        }
+        memcpy(buffer + used, data, length);
+        used += length;
+    }
+
+    void write(const char *text)
+    {
+        write(text, strlen(text));
+    }
+
+    // write the grid as a single 81 character line
+    void writeGrid(const int (&grid)[9][9])
+    {
+        if (used + 82 > sizeof(buffer))
+            flush();
+
+        for (int i = 0; i < 81; ++i)
+            buffer[used + i] = static_cast<char>('0' + grid[i / 9][i % 9]);
+        buffer[used + 81] = '\n';
+        used += 82;
+    }
+
+    // write a board of any size as a single line
+    void writeCells(const int *cells, int count)
+    {
+        if (used + count + 1 > sizeof(buffer))
+            flush();
+
+        for (int i = 0; i < count; ++i)
+            buffer[used + i] = cellChar(cells[i]);
+        buffer[used + count] = '\n';
+        used += count + 1;
+    }
+
+    void flush()
+    {
+        writeAll(buffer, used);
+        used = 0;
+    }
+
+private:
+    int fd;
+    size_t used = 0;
+    char buffer[1 << 16];
+
+    void writeAll(const char *data, size_t length)
+    {
+        while (length > 0)
+        {
+            ssize_t count = ::write(fd, data, length);
+            if (count <= 0)
+                return;
+            data += count;
+            length -= count;
+        }
+    }
+};
+
+// Wall clock timer shared by every way of running the solvers
+class Timer
+{
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    void reset()
+    {
+        start = std::chrono::steady_clock::now();
+    }
+
+    double elapsedMilliseconds() const
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Solve every puzzle in the file (or stdin for "-") and write one solved line per puzzle to stdout
+// The same grid is reused for every puzzle so the loop never allocates
+// 256 and 625 character lines are solved as 16x16 and 25x25 boards by solvers that support them
+// with validate every 9x9 answer is checked against its puzzle first and a wrong one is never written
+inline int solveStream(const char *path, const Solver &solver, bool validate = false)
+{
+    PuzzleReader reader;
+    if (!reader.open(path))
+    {
+        std::cerr << "Could not open " << path << "\n";
+        return 1;
+    }
+
+    OutputWriter writer;
+    int grid[9][9];
+    int puzzle[9][9];
+    int cells[625];
+    const char *line = nullptr;
+    size_t length = 0;
+    const unsigned char *record = nullptr;
+    long puzzles = 0, solved = 0, invalid = 0;
+
+    Timer timer;
+
+    while (true)
+    {
+        // packed records are always 9x9
+        if (reader.isPacked() ? !reader.nextRecord(record) : !reader.nextLine(line, length))
+            break;
+
+        size_t cellCount = reader.isPacked() ? 81 : puzzleLength(line, length);
+        int boxSize = cellCount == 256 ? 4 : cellCount == 625 ? 5 : 3;
+        bool large = boxSize != 3;
+
+        bool valid = reader.isPacked() ? unpackGrid(record, grid)
+                     : large           ? solver.solveAnySize && parseCells(line, length, cells, cellCount, boxSize * boxSize)
+                                       : parsePuzzle(line, length, grid);
+        if (!valid)
+        {
+            writer.flush();
+            std::cerr << "Invalid puzzle on " << reader.lineName() << " " << reader.lineNumber() << "\n";
+            if (large && !solver.solveAnySize)
+                std::cerr << solver.name << " only solves 9x9 puzzles, try --solver=v11\n";
+            return 1;
+        }
+
+        ++puzzles;
+        if (validate && !large)
+            memcpy(puzzle, grid, sizeof(puzzle));
+        bool found = large ? solver.solveAnySize(cells, boxSize) : solver.solve(grid);
+        if (found && validate && !large && !validateSolution(puzzle, grid))
+        {
+            ++invalid;
+            writer.write("Invalid solution!\n");
+        }
+        else if (found)
+        {
+            ++solved;
+            if (large)
+                writer.writeCells(cells, cellCount);
+            else
+                writer.writeGrid(grid);
+        }
+        else
+        {
+            writer.write("No solution found!\n");
+        }
+    }
+    writer.flush();
+
+    std::cerr << "Solved " << solved << " of " << puzzles << " puzzles in " << timer.elapsedMilliseconds() << " milliseconds\n";
+    if (validate)
+        std::cerr << invalid << " answers failed validation\n";
+    return invalid == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,90 @@
+// checks that v4's search allocates nothing: operator new is replaced with a counter, and every puzzle of the
+// corpus is solved with the counter watching
+
+#include <iostream> // Includes the standard input/output stream library
+#include <vector>
+#include <atomic>
+#include <cstdlib> // For malloc/free
+#include <new>     // For std::bad_alloc
+#include "solvers.h"
+#include "sudoku_io.h"
+#include "validate.h"
+
+std::atomic<long> allocations{0};
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+    void *memory = std::malloc(size > 0 ? size : 1);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main()
+{
+    // every puzzle is read before counting starts, so only the solver is watched
+    const char *files[] = {"puzzles/easy.txt", "puzzles/hard.txt", "puzzles/17clue.txt", "puzzles/pathological.txt"};
+    std::vector<Grid> puzzles;
+    for (const char *path : files)
+    {
+        PuzzleReader reader;
+        if (!reader.open(path))
+        {
+            std::cerr << "Could not open " << path << "\n";
+            return 1;
+        }
+
+        Grid grid;
+        bool valid;
+        while (nextPuzzle(reader, grid.cells, valid))
+            if (valid)
+                puzzles.push_back(grid);
+    }
+    std::vector<Grid> solutions(puzzles);
+
+    long before = allocations;
+    long solved = 0;
+    for (Grid &grid : solutions)
+        solved += v4::sudokuSolver(grid.cells);
+    long allocated = allocations - before;
+
+    long wrong = 0;
+    for (size_t i = 0; i < puzzles.size(); ++i)
+        wrong += !validateSolution(puzzles[i].cells, solutions[i].cells);
+
+    std::cerr << "v4 allocations: " << allocated << " while solving " << solved << " of " << puzzles.size()
+              << " puzzles\n";
+    if (allocated != 0 || wrong != 0)
+    {
+        if (wrong != 0)
+            std::cerr << wrong << " answers are not solutions\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+// checks canonicalForm over the puzzle corpus and over grids with few clues:
+// every shuffled copy of a puzzle has the same canonical form, the transform gives the canonical grid, and a
+// solution of the canonical grid mapped back with applyInverse solves the original puzzle
+
+#include <iostream> // Includes the standard input/output stream library
+#include <string>
+#include <random>    // For mt19937
+#include <algorithm> // For std::shuffle
+#include <cstring>   // For memcmp
+#include "solvers.h"
+#include "sudoku_io.h"
+#include "validate.h"
+#include "canonical.h"
+
+const int shuffles = 4; // shuffled copies checked for every puzzle
+
+// a random symmetry: transpose or not, bands and the rows inside them, stacks and their columns, and the labels
+Transform randomTransform(std::mt19937 &random)
+{
+    Transform transform;
+    transform.transpose = random() & 1;
+
+    int bands[3] = {0, 1, 2}, stacks[3] = {0, 1, 2};
+    std::shuffle(bands, bands + 3, random);
+    std::shuffle(stacks, stacks + 3, random);
+    for (int b = 0; b < 3; ++b)
+    {
+        int rows[3] = {0, 1, 2}, cols[3] = {0, 1, 2};
+        std::shuffle(rows, rows + 3, random);
+        std::shuffle(cols, cols + 3, random);
+        for (int i = 0; i < 3; ++i)
+        {
+            transform.rows[b * 3 + i] = bands[b] * 3 + rows[i];
+            transform.cols[b * 3 + i] = stacks[b] * 3 + cols[i];
+        }
+    }
+
+    transform.labels[0] = 0;
+    for (int value = 1; value < 10; ++value)
+        transform.labels[value] = value;
+    std::shuffle(transform.labels + 1, transform.labels + 10, random);
+    return transform;
+}
+
+bool sameGrid(const int (&a)[9][9], const int (&b)[9][9])
+{
+    return memcmp(a, b, sizeof(a)) == 0;
+}
+
+// false (with a message) if the puzzle breaks any of the checks
+bool checkPuzzle(const int (&grid)[9][9], std::mt19937 &random, bool solve, const std::string &where)
+{
+    int canonical[9][9], mapped[9][9];
+    Transform transform = canonicalForm(grid, canonical);
+
+    applyTransform(transform, grid, mapped);
+    if (!sameGrid(mapped, canonical))
+    {
+        std::cerr << where << ": the transform does not give the canonical grid\n";
+        return false;
+    }
+
+    for (int s = 0; s < shuffles; ++s)
+    {
+        int shuffled[9][9], other[9][9];
+        applyTransform(randomTransform(random), grid, shuffled);
+        canonicalForm(shuffled, other);
+        if (!sameGrid(other, canonical))
+        {
+            std::cerr << where << ": a shuffled copy has a different canonical form\n";
+            return false;
+        }
+    }
+
+    if (solve)
+    {
+        int solution[9][9], original[9][9];
+        memcpy(solution, canonical, sizeof(solution));
+        if (!v11::sudokuSolver(solution))
+        {
+            std::cerr << where << ": the canonical grid has no solution\n";
+            return false;
+        }
+        applyInverse(transform, solution, original);
+        if (!validateSolution(grid, original))
+        {
+            std::cerr << where << ": the solution mapped back does not solve the puzzle\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    std::mt19937 random(2024);
+    long checked = 0, failed = 0;
+    Timer timer;
+
+    const char *files[] = {"puzzles/easy.txt", "puzzles/hard.txt", "puzzles/17clue.txt", "puzzles/pathological.txt"};
+    Grid solved = {};
+    bool haveSolved = false;
+    for (const char *path : files)
+    {
+        PuzzleReader reader;
+        if (!reader.open(path))
+        {
+            std::cerr << "Could not open " << path << "\n";
+            return 1;
+        }
+
+        Grid grid;
+        bool valid;
+        while (nextPuzzle(reader, grid.cells, valid))
+        {
+            std::string where = std::string(path) + " line " + std::to_string(reader.lineNumber());
+            if (!valid)
+            {
+                std::cerr << where << ": not a puzzle\n";
+                return 1;
+            }
+            failed += !checkPuzzle(grid.cells, random, true, where);
+            ++checked;
+
+            if (!haveSolved)
+            {
+                solved = grid;
+                haveSolved = v11::sudokuSolver(solved.cells);
+            }
+        }
+    }
+
+    // grids with few clues tie almost everywhere, which is where the search has the most ways to go
+    if (!haveSolved)
+    {
+        std::cerr << "No puzzle to take clues from\n";
+        return 1;
+    }
+    for (int clues = 0; clues <= 20; ++clues)
+        for (int n = 0; n < 10; ++n)
+        {
+            int cells[81], grid[9][9] = {};
+            for (int i = 0; i < 81; ++i)
+                cells[i] = i;
+            std::shuffle(cells, cells + 81, random);
+            for (int i = 0; i < clues; ++i)
+                grid[cells[i] / 9][cells[i] % 9] = solved.cells[cells[i] / 9][cells[i] % 9];
+
+            std::string where = std::to_string(clues) + " clues, grid " + std::to_string(n);
+            failed += !checkPuzzle(grid, random, true, where);
+            ++checked;
+        }
+
+    std::cerr << "Canonical form: " << checked - failed << " of " << checked << " puzzles passed in "
+              << timer.elapsedMilliseconds() << " milliseconds\n";
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// fixed set of worker threads that are started once and reused for every job
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "stats.h"
+
+class ThreadPool
+{
+public:
+    // jobs get the index of the worker running them so they can use per-worker state
+    typedef std::function<void(int worker)> Job;
+
+    explicit ThreadPool(int threadCount)
+    {
+        for (int id = 0; id < threadCount; ++id)
+            workers.emplace_back(&ThreadPool::workerLoop, this, id);
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // finishes the jobs already submitted, then stops the workers
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &t : workers)
+            t.join();
+    }
+
+    void submit(Job job)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    int size() const
+    {
+        return workers.size();
+    }
+
+    // number of threads to use when the caller asks for 0 (all cores)
+    static int defaultSize()
+    {
+        unsigned cores = std::thread::hardware_concurrency();
+        return cores > 0 ? cores : 1;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop(int id)
+    {
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [this]
+                          { return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                    return; // stopping and nothing left to do
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job(id);
+        }
+    }
+};
+
+// jobs on a pool that are waited for together, such as one round of chunks
+// a job must not wait on its own group, it would hold up the worker it runs on
+// with make STATS=1 the search counters of the jobs are added to the waiting thread's own
+class JobGroup
+{
+public:
+    explicit JobGroup(ThreadPool &pool) : pool(pool) {}
+
+    JobGroup(const JobGroup &) = delete;
+    JobGroup &operator=(const JobGroup &) = delete;
+
+    // the jobs still running refer to the group
+    ~JobGroup()
+    {
+        wait();
+    }
+
+    void submit(ThreadPool::Job job)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ++pending;
+        }
+        pool.submit([this, job = std::move(job)](int worker)
+                    {
+            job(worker);
+
+            std::lock_guard<std::mutex> guard(lock);
+#ifdef SUDOKU_STATS
+            stats += solverStats;
+            solverStats = SolverStats();
+#endif
+            if (--pending == 0)
+                finished.notify_all(); });
+    }
+
+    // returns once every job submitted so far has finished
+    void wait()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [this]
+                      { return pending == 0; });
+#ifdef SUDOKU_STATS
+        solverStats += stats;
+        stats = SolverStats();
+#endif
+    }
+
+private:
+    ThreadPool &pool;
+    std::mutex lock;
+    std::condition_variable finished;
+    long pending = 0;
+#ifdef SUDOKU_STATS
+    SolverStats stats;
+#endif
+};
+
+#endif
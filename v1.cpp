@@ -1,7 +1,10 @@
 // basic backtracking
 
-#include <iostream> // Includes the standard input/output stream library
-#include <chrono>   // For timing
+#include "solvers.h"
+#include "stats.h"
+
+namespace v1
+{
 
 bool validateRowCol(int (&grid)[9][9], int row, int col, int num)
 {
@@ -28,6 +31,8 @@ bool validateRowCol(int (&grid)[9][9], int row, int col, int num)
 
 bool sudokuSolver(int (&grid)[9][9])
 {
+    STATS_INC(nodes);
+
     for (int row = 0; row < 9; ++row)
     {
         for (int col = 0; col < 9; ++col)
@@ -48,6 +53,7 @@ bool sudokuSolver(int (&grid)[9][9])
                             return true;
 
                         // if it was not the correct number, backtrack and try something else
+                        STATS_INC(backtracks);
                         grid[row][col] = 0;
                     }
                 }
@@ -61,53 +67,4 @@ bool sudokuSolver(int (&grid)[9][9])
     return true;
 }
 
-int main()
-{
-    // set up inputs
-    // Unsolved Sudoku puzzle (0 represents empty cells)
-    int sudoku[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
-
-    // Record the start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Call the function
-    bool solved = sudokuSolver(sudoku);
-
-    // Record the end time
-    auto end = std::chrono::high_resolution_clock::now();
-
-    // Calculate the duration in milliseconds
-    std::chrono::duration<double, std::milli> elapsed = end - start;
-
-    // Output the time taken in milliseconds
-    std::cout << "Execution time: " << elapsed.count() << " milliseconds\n"
-              << std::endl;
-
-    // output solved sudoku if it was solved
-    if (solved)
-    {
-        for (int row = 0; row < 9; ++row)
-        {
-            for (int col = 0; col < 9; ++col)
-            {
-                std::cout << sudoku[row][col] << ", ";
-            }
-            std::cout << "\n";
-        }
-    }
-    else
-    {
-        std::cout << "No solution found!\n";
-    }
-
-    return 0; // Indicates successful program termination
-}
\ No newline at end of file
+} // namespace v1
@@ -0,0 +1,238 @@
+// Dancing Links (Knuth's Algorithm X) over the exact cover form of sudoku
+// each of the 729 rows is one number in one cell, and covers 4 of the 324 columns:
+// the cell is filled, the row has the number, the column has the number, and the 3x3 grid has the number
+// the links are built once per thread, and every solve puts them back the way it found them
+
+#include "solvers.h"
+#include "stats.h"
+
+namespace v10
+{
+
+const int columnCount = 324;
+const int rowCount = 729;
+const int root = columnCount;                        // header node that links the uncovered columns
+const int nodeCount = columnCount + 1 + rowCount * 4; // headers, then 4 nodes per row
+
+struct Matrix
+{
+    int left[nodeCount], right[nodeCount], up[nodeCount], down[nodeCount];
+    int column[nodeCount]; // column header of every node
+    int row[nodeCount];    // matrix row of every node, -1 for headers
+    int size[columnCount]; // nodes left in each column
+    int rowStart[rowCount];
+
+    Matrix()
+    {
+        // headers in a circle through the root, each column starts empty
+        for (int c = 0; c <= columnCount; ++c)
+        {
+            left[c] = c == 0 ? root : c - 1;
+            right[c] = c == root ? 0 : c + 1;
+            up[c] = down[c] = column[c] = c;
+            row[c] = -1;
+        }
+        right[root - 1] = root;
+        left[root] = root - 1;
+        for (int c = 0; c < columnCount; ++c)
+            size[c] = 0;
+
+        int node = columnCount + 1;
+        for (int r = 0; r < rowCount; ++r)
+        {
+            int cell = r / 9, number = r % 9;
+            int rowIndex = cell / 9, col = cell % 9, subgrid = (rowIndex / 3) * 3 + col / 3;
+            int columns[4] = {cell, 81 + rowIndex * 9 + number, 162 + col * 9 + number, 243 + subgrid * 9 + number};
+
+            rowStart[r] = node;
+            for (int k = 0; k < 4; ++k, ++node)
+            {
+                int c = columns[k];
+
+                // append to the bottom of the column
+                column[node] = c;
+                row[node] = r;
+                up[node] = up[c];
+                down[node] = c;
+                down[up[c]] = node;
+                up[c] = node;
+                ++size[c];
+
+                // 4 node circle for the row
+                left[node] = k == 0 ? node + 3 : node - 1;
+                right[node] = k == 3 ? node - 3 : node + 1;
+            }
+        }
+    }
+
+    bool isCovered(int c) const
+    {
+        return right[left[c]] != c;
+    }
+
+    // take the column out of the header list and every row that uses it out of the other columns
+    void cover(int c)
+    {
+        right[left[c]] = right[c];
+        left[right[c]] = left[c];
+        for (int i = down[c]; i != c; i = down[i])
+        {
+            for (int j = right[i]; j != i; j = right[j])
+            {
+                down[up[j]] = down[j];
+                up[down[j]] = up[j];
+                --size[column[j]];
+            }
+        }
+    }
+
+    // exact reverse of cover, so the links dance back into place
+    void uncover(int c)
+    {
+        for (int i = up[c]; i != c; i = up[i])
+        {
+            for (int j = left[i]; j != i; j = left[j])
+            {
+                ++size[column[j]];
+                down[up[j]] = j;
+                up[down[j]] = j;
+            }
+        }
+        right[left[c]] = c;
+        left[right[c]] = c;
+    }
+
+    // choosing a row covers every column it is in, starting with the one it was found through
+    void select(int node)
+    {
+        cover(column[node]);
+        for (int j = right[node]; j != node; j = right[j])
+            cover(column[j]);
+    }
+
+    void unselect(int node)
+    {
+        for (int j = left[node]; j != node; j = left[j])
+            uncover(column[j]);
+        uncover(column[node]);
+    }
+};
+
+// building the links is the expensive part, so each thread keeps one and reuses it for every puzzle
+thread_local Matrix matrix;
+
+// state of one solve or count
+struct Search
+{
+    Matrix &m;
+    int chosen[81];   // rows picked so far, givens first
+    int solution[81]; // rows of the first solution found
+    long found = 0;
+    long limit;
+    long guesses = 0; // nodes where the smallest column still had more than one row
+
+    Search(Matrix &matrix, long limit) : m(matrix), limit(limit) {}
+
+    void run(int depth)
+    {
+        STATS_INC(nodes);
+
+        // every column covered means every constraint is met exactly once
+        if (m.right[root] == root)
+        {
+            if (found == 0)
+                for (int i = 0; i < depth; ++i)
+                    solution[i] = chosen[i];
+            ++found;
+            return;
+        }
+
+        // column with the fewest rows left
+        int best = m.right[root];
+        for (int c = m.right[best]; c != root && m.size[best] > 1; c = m.right[c])
+            if (m.size[c] < m.size[best])
+                best = c;
+
+        if (m.size[best] == 0)
+            return;
+        if (m.size[best] > 1)
+            ++guesses;
+
+        m.cover(best);
+        for (int r = m.down[best]; r != best && found < limit; r = m.down[r])
+        {
+            chosen[depth] = m.row[r];
+            for (int j = m.right[r]; j != r; j = m.right[j])
+                m.cover(m.column[j]);
+
+            run(depth + 1);
+
+            for (int j = m.left[r]; j != r; j = m.left[j])
+                m.uncover(m.column[j]);
+            if (found < limit)
+                STATS_INC(backtracks);
+        }
+        m.uncover(best);
+    }
+};
+
+// select the givens, search, then unselect the givens in reverse so the matrix is clean for the next puzzle
+// returns false without searching if the givens clash or are out of range
+bool searchPuzzle(const int (&grid)[9][9], Search &search)
+{
+    Matrix &m = search.m;
+    int givens = 0;
+    bool valid = true;
+
+    for (int cell = 0; cell < 81 && valid; ++cell)
+    {
+        int value = grid[cell / 9][cell % 9];
+        if (value == 0)
+            continue;
+        if (value < 0 || value > 9)
+        {
+            valid = false;
+            break;
+        }
+
+        // a given whose row lost a column to an earlier given repeats a number
+        int node = m.rowStart[cell * 9 + value - 1];
+        for (int k = 0; k < 4; ++k)
+            if (m.isCovered(m.column[node + k]))
+                valid = false;
+        if (!valid)
+            break;
+
+        m.select(node);
+        search.chosen[givens++] = m.row[node];
+    }
+
+    if (valid)
+        search.run(givens);
+
+    while (givens > 0)
+        m.unselect(m.rowStart[search.chosen[--givens]]);
+    return valid;
+}
+
+long countSolutions(const int (&grid)[9][9], long limit, long *guesses)
+{
+    Search search(matrix, limit);
+    searchPuzzle(grid, search);
+    if (guesses)
+        *guesses = search.guesses;
+    return search.found;
+}
+
+bool sudokuSolver(int (&grid)[9][9])
+{
+    Search search(matrix, 1);
+    if (!searchPuzzle(grid, search) || search.found == 0)
+        return false;
+
+    for (int r : search.solution)
+        grid[r / 81][r / 9 % 9] = r % 9 + 1;
+    return true;
+}
+
+} // namespace v10
@@ -0,0 +1,368 @@
+// every cell keeps its candidates as a bit mask, and every row, column and box keeps a mask of the
+// numbers placed in it like v3. After each placement naked singles (cells with one candidate left) and hidden
+// singles (numbers with one place left in a unit) are filled in until nothing changes, then the search
+// branches on the cell with the fewest candidates like v4. Boards are small, so each branch copies the board
+// instead of undoing its changes.
+// Everything is a template over the box size B (B = 3 for 9x9), and each size is compiled as its own code with
+// its own tables and the narrowest mask type that holds B*B numbers.
+
+#include <cstdint>     // For uint16_t/uint32_t/uint64_t
+#include <type_traits> // For std::conditional_t
+#include <algorithm>   // For std::min
+#include <atomic>
+#include <vector>
+#include "solvers.h"
+#include "stats.h"
+#include "peers.h"
+#include "thread_pool.h"
+
+namespace v11
+{
+
+// narrowest unsigned type with a bit for every number
+template <int N>
+using MaskFor = std::conditional_t<(N <= 16), uint16_t, std::conditional_t<(N <= 32), uint32_t, uint64_t>>;
+
+template <int B>
+inline constexpr PeerTables<B> tables;
+
+template <int B>
+struct Board
+{
+    typedef PeerTables<B> Tables;
+    typedef MaskFor<Tables::size> Mask;
+
+    static constexpr Mask allNumbers = Mask(Mask(~Mask(0)) >> (8 * sizeof(Mask) - Tables::size));
+    static constexpr int openWords = (Tables::cellCount + 63) / 64;
+
+    Mask cells[Tables::cellCount]; // candidates of each cell, a single bit once it is placed
+    Mask used[Tables::unitCount];  // numbers placed in each row, column and box
+    uint64_t open[openWords];      // one bit per cell that has not been placed yet
+    int openCount;
+};
+
+// cells that became naked singles and still have to be placed
+// propagate always empties it before the search goes deeper, so one is enough for a whole solve
+template <int B>
+struct Pending
+{
+    int cells[PeerTables<B>::cellCount];
+    int count = 0;
+};
+
+template <int B>
+bool isOpen(const Board<B> &board, int cell)
+{
+    return (board.open[cell >> 6] >> (cell & 63)) & 1;
+}
+
+template <typename Mask>
+bool isSingle(Mask mask)
+{
+    return (mask & (mask - 1)) == 0;
+}
+
+// put the number in the cell and take it out of the candidates of every peer
+// returns false if that leaves a peer with no candidates or the number is already in one of the cell's units
+template <int B>
+bool place(Board<B> &board, int cell, typename Board<B>::Mask bit, Pending<B> &pending)
+{
+    if (!isOpen(board, cell))
+        return board.cells[cell] == bit;
+    if (!(board.cells[cell] & bit))
+        return false;
+
+    STATS_INC(propagations);
+    board.cells[cell] = bit;
+    board.open[cell >> 6] &= ~(uint64_t(1) << (cell & 63));
+    --board.openCount;
+
+    for (int unit : tables<B>.cellUnits[cell])
+    {
+        if (board.used[unit] & bit)
+            return false;
+        board.used[unit] |= bit;
+    }
+
+    for (int peer : tables<B>.peers[cell])
+    {
+        if (!isOpen(board, peer) || !(board.cells[peer] & bit))
+            continue;
+        board.cells[peer] &= ~bit;
+        if (board.cells[peer] == 0)
+            return false;
+        if (isSingle(board.cells[peer]))
+            pending.cells[pending.count++] = peer;
+    }
+    return true;
+}
+
+// fill naked and hidden singles until neither finds anything new, false on a contradiction
+template <int B>
+bool propagate(Board<B> &board, Pending<B> &pending)
+{
+    typedef typename Board<B>::Mask Mask;
+
+    while (true)
+    {
+        while (pending.count > 0)
+        {
+            int cell = pending.cells[--pending.count];
+            if (!place(board, cell, board.cells[cell], pending))
+                return false;
+        }
+
+        bool progress = false;
+        for (int u = 0; u < PeerTables<B>::unitCount; ++u)
+        {
+            // numbers that fit one open cell of the unit, and numbers that fit more than one
+            Mask once = 0, twice = 0;
+            for (int cell : tables<B>.units[u])
+            {
+                if (!isOpen(board, cell))
+                    continue;
+                twice |= once & board.cells[cell];
+                once |= board.cells[cell];
+            }
+
+            // a number that is neither placed nor possible anywhere in the unit
+            if (Mask(once | board.used[u]) != Board<B>::allNumbers)
+                return false;
+
+            for (Mask hidden = once & ~twice; hidden; hidden &= hidden - 1)
+            {
+                Mask bit = hidden & -hidden;
+                for (int cell : tables<B>.units[u])
+                {
+                    if (isOpen(board, cell) && (board.cells[cell] & bit))
+                    {
+                        if (!place(board, cell, bit, pending))
+                            return false;
+                        break;
+                    }
+                }
+                progress = true;
+            }
+        }
+
+        if (!progress && pending.count == 0)
+            return true;
+    }
+}
+
+// most constrained open cell, a cell with two candidates cannot be beaten
+template <int B>
+int mostConstrainedCell(const Board<B> &board)
+{
+    int bestCell = -1, bestCount = PeerTables<B>::size + 1;
+    for (int word = 0; word < Board<B>::openWords && bestCount > 2; ++word)
+    {
+        for (uint64_t bits = board.open[word]; bits && bestCount > 2; bits &= bits - 1)
+        {
+            int cell = word * 64 + __builtin_ctzll(bits);
+            int count = __builtin_popcountll(board.cells[cell]);
+            if (count < bestCount)
+            {
+                bestCell = cell;
+                bestCount = count;
+            }
+        }
+    }
+    return bestCell;
+}
+
+template <int B>
+bool search(Board<B> &board, Pending<B> &pending)
+{
+    typedef typename Board<B>::Mask Mask;
+
+    STATS_INC(nodes);
+
+    if (board.openCount == 0)
+        return true;
+
+    int bestCell = mostConstrainedCell(board);
+    for (Mask candidates = board.cells[bestCell]; candidates; candidates &= candidates - 1)
+    {
+        Board<B> copy = board;
+        pending.count = 0;
+        if (place(copy, bestCell, Mask(candidates & -candidates), pending) && propagate(copy, pending) &&
+            search(copy, pending))
+        {
+            board = copy;
+            return true;
+        }
+        STATS_INC(backtracks);
+    }
+    return false;
+}
+
+// same search, but every solution below the board is added to found until it reaches limit
+// found is shared by every thread counting the same puzzle
+template <int B>
+void countBelow(const Board<B> &board, Pending<B> &pending, long limit, std::atomic<long> &found)
+{
+    typedef typename Board<B>::Mask Mask;
+
+    STATS_INC(nodes);
+
+    if (found.load(std::memory_order_relaxed) >= limit)
+        return;
+    if (board.openCount == 0)
+    {
+        found.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    int bestCell = mostConstrainedCell(board);
+    for (Mask candidates = board.cells[bestCell]; candidates; candidates &= candidates - 1)
+    {
+        Board<B> copy = board;
+        pending.count = 0;
+        if (place(copy, bestCell, Mask(candidates & -candidates), pending) && propagate(copy, pending))
+            countBelow(copy, pending, limit, found);
+    }
+}
+
+// place the givens and propagate, false if the puzzle is already impossible
+template <int B>
+bool startBoard(Board<B> &board, const int *cells, Pending<B> &pending)
+{
+    typedef PeerTables<B> Tables;
+    typedef typename Board<B>::Mask Mask;
+
+    for (int i = 0; i < Tables::cellCount; ++i)
+        board.cells[i] = Board<B>::allNumbers;
+    for (int i = 0; i < Tables::unitCount; ++i)
+        board.used[i] = 0;
+    for (int i = 0; i < Board<B>::openWords; ++i)
+    {
+        int bits = Tables::cellCount - i * 64;
+        board.open[i] = bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    }
+    board.openCount = Tables::cellCount;
+
+    for (int cell = 0; cell < Tables::cellCount; ++cell)
+    {
+        int value = cells[cell];
+        if (value < 0 || value > Tables::size)
+            return false;
+        if (value != 0 && !place(board, cell, Mask(Mask(1) << (value - 1)), pending))
+            return false;
+    }
+
+    return propagate(board, pending);
+}
+
+template <int B>
+bool solve(int *cells)
+{
+    Board<B> board;
+    Pending<B> pending;
+    if (!startBoard(board, cells, pending) || !search(board, pending))
+        return false;
+
+    for (int cell = 0; cell < PeerTables<B>::cellCount; ++cell)
+        cells[cell] = __builtin_ctzll(board.cells[cell]) + 1;
+    return true;
+}
+
+template <int B>
+long countSolutions(const int *cells, long limit, ThreadPool *pool)
+{
+    typedef typename Board<B>::Mask Mask;
+
+    Board<B> board;
+    Pending<B> pending;
+    if (limit <= 0 || !startBoard(board, cells, pending))
+        return 0;
+
+    std::atomic<long> found(0);
+
+    // a uniqueness check stops at the second solution, far too soon for threads to pay off
+    if (pool == nullptr || pool->size() <= 1 || limit <= 2)
+    {
+        countBelow(board, pending, limit, found);
+        return std::min(found.load(), limit);
+    }
+
+    // expand the tree a level at a time until there are plenty of subtrees to hand out
+    std::vector<Board<B>> frontier(1, board);
+    const size_t target = pool->size() * 16;
+    while (frontier.size() < target && found.load() < limit)
+    {
+        std::vector<Board<B>> next;
+        for (const Board<B> &parent : frontier)
+        {
+            STATS_INC(nodes); // the same node countBelow would have counted
+            if (parent.openCount == 0)
+            {
+                ++found;
+                continue;
+            }
+
+            int bestCell = mostConstrainedCell(parent);
+            for (Mask candidates = parent.cells[bestCell]; candidates; candidates &= candidates - 1)
+            {
+                Board<B> child = parent;
+                pending.count = 0;
+                if (place(child, bestCell, Mask(candidates & -candidates), pending) && propagate(child, pending))
+                    next.push_back(child);
+            }
+        }
+        frontier.swap(next);
+        if (frontier.empty())
+            break;
+    }
+
+    // every worker takes the next subtree until they run out or the limit is reached
+    std::atomic<size_t> nextSubtree(0);
+    JobGroup workers(*pool);
+    for (int t = 0; t < pool->size(); ++t)
+    {
+        workers.submit([&](int)
+                       {
+            Pending<B> workerPending;
+            size_t i;
+            while (found.load(std::memory_order_relaxed) < limit && (i = nextSubtree++) < frontier.size())
+                countBelow(frontier[i], workerPending, limit, found); });
+    }
+    workers.wait();
+
+    return std::min(found.load(), limit);
+}
+
+// one specialised copy of the engine per supported size
+template bool solve<3>(int *cells);
+template bool solve<4>(int *cells);
+template bool solve<5>(int *cells);
+template long countSolutions<3>(const int *cells, long limit, ThreadPool *pool);
+template long countSolutions<4>(const int *cells, long limit, ThreadPool *pool);
+template long countSolutions<5>(const int *cells, long limit, ThreadPool *pool);
+
+bool solveAnySize(int *cells, int boxSize)
+{
+    switch (boxSize)
+    {
+    case 3:
+        return solve<3>(cells);
+    case 4:
+        return solve<4>(cells);
+    case 5:
+        return solve<5>(cells);
+    default:
+        return false;
+    }
+}
+
+bool sudokuSolver(int (&grid)[9][9])
+{
+    return solve<3>(&grid[0][0]);
+}
+
+long countSolutions(const int (&grid)[9][9], long limit, ThreadPool *pool)
+{
+    return countSolutions<3>(&grid[0][0], limit, pool);
+}
+
+} // namespace v11
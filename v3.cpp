@@ -1,17 +1,22 @@
 // bitmasks are used to keep track of the numbers that are already used in the row, column, and subgrid.
 
-#include <iostream>      // Includes the standard input/output stream library
-#include <chrono>        // For timing
 #include <unordered_set> // For hashsets
+#include "solvers.h"
+#include "stats.h"
 
-#define N 9 // Size of the grid
+namespace v3
+{
 
-int rowMasks[N] = {0};
-int colMasks[N] = {0};
-int subgridMasks[N] = {0};
+#define N 9 // Size of the grid
 
-bool sudokuSolverRecursive(int (&grid)[9][9])
+bool sudokuSolverRecursive(int (&grid)[9][9], SolverContext &context)
 {
+    int (&rowMasks)[N] = context.rowMasks;
+    int (&colMasks)[N] = context.colMasks;
+    int (&subgridMasks)[N] = context.subgridMasks;
+
+    STATS_INC(nodes);
+
     // loop through everything twice and try inserting new
     for (int row = 0; row < 9; ++row)
     {
@@ -38,10 +43,11 @@ bool sudokuSolverRecursive(int (&grid)[9][9])
                     subgridMasks[subgrid] |= candidateBit;
 
                     // Recursively try to solve the next cells
-                    if (sudokuSolverRecursive(grid))
+                    if (sudokuSolverRecursive(grid, context))
                         return true;
 
                     // Backtrack: undo placing the number
+                    STATS_INC(backtracks);
                     grid[row][col] = 0;
                     rowMasks[row] &= ~candidateBit;
                     colMasks[col] &= ~candidateBit;
@@ -61,76 +67,115 @@ bool sudokuSolverRecursive(int (&grid)[9][9])
     return true;
 }
 
-bool sudokuSolver(int (&grid)[9][9])
+// set the masks from the givens, false if a number is out of range or repeated in a row, column or subgrid
+// such a puzzle has no solution, and searching it anyway can take practically forever
+bool setGivenMasks(const int (&grid)[9][9], SolverContext &context)
 {
-    // loop through it once and ensure masks match what is already there
-    for (int row = 0; row < 9; ++row)
+    int (&rowMasks)[N] = context.rowMasks;
+    int (&colMasks)[N] = context.colMasks;
+    int (&subgridMasks)[N] = context.subgridMasks;
+
+    // the context may hold masks from a previous puzzle
+    for (int i = 0; i < N; ++i)
+        rowMasks[i] = colMasks[i] = subgridMasks[i] = 0;
+
+    for (int row = 0; row < N; ++row)
     {
-        for (int col = 0; col < 9; ++col)
+        for (int col = 0; col < N; ++col)
         {
-            // check to see if the cell is empty
-            if (grid[row][col] != 0)
-            {
-                int subgrid = (row / 3) * 3 + col / 3; // Subgrid index (0 to 8)
+            int value = grid[row][col];
+            if (value == 0)
+                continue;
+            if (value < 0 || value > N)
+                return false;
 
-                // Set the appropriate bits indicating that the number is taken
-                rowMasks[row] |= (1 << (grid[row][col] - 1));         // Mark number as used in the row
-                colMasks[col] |= (1 << (grid[row][col] - 1));         // Mark number as used in the column
-                subgridMasks[subgrid] |= (1 << (grid[row][col] - 1)); // Mark number as used in the subgrid
-            }
+            int bit = 1 << (value - 1), subgrid = (row / 3) * 3 + col / 3;
+            if ((rowMasks[row] | colMasks[col] | subgridMasks[subgrid]) & bit)
+                return false;
+            rowMasks[row] |= bit;
+            colMasks[col] |= bit;
+            subgridMasks[subgrid] |= bit;
         }
     }
+    return true;
+}
 
-    return sudokuSolverRecursive(grid);
+bool sudokuSolver(int (&grid)[9][9], SolverContext &context)
+{
+    if (!setGivenMasks(grid, context))
+        return false;
+    return sudokuSolverRecursive(grid, context);
 }
 
-int main()
+// same search as sudokuSolverRecursive, but every solution goes to the sink and the search carries on
+// cells before start are already filled, returns true once the sink asks to stop
+bool enumerateRecursive(int (&grid)[9][9], SolverContext &context, int start, const SolutionSink &sink, long &found)
 {
-    // set up inputs
-    // Unsolved Sudoku puzzle (0 represents empty cells)
-    int sudoku[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
-
-    // Record the start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Call the function
-    bool solved = sudokuSolver(sudoku);
-
-    // Record the end time
-    auto end = std::chrono::high_resolution_clock::now();
-
-    // Calculate the duration in milliseconds
-    std::chrono::duration<double, std::milli> elapsed = end - start;
-
-    // Output the time taken in milliseconds
-    std::cout << "Execution time: " << elapsed.count() << " milliseconds\n"
-              << std::endl;
-
-    // output solved sudoku if it was solved
-    if (solved)
+    int (&rowMasks)[N] = context.rowMasks;
+    int (&colMasks)[N] = context.colMasks;
+    int (&subgridMasks)[N] = context.subgridMasks;
+
+    STATS_INC(nodes);
+
+    // find the next empty cell
+    int cell = start;
+    while (cell < N * N && grid[cell / N][cell % N] != 0)
+        ++cell;
+
+    // every cell is filled, hand the solution over
+    if (cell == N * N)
     {
-        for (int row = 0; row < 9; ++row)
-        {
-            for (int col = 0; col < 9; ++col)
-            {
-                std::cout << sudoku[row][col] << ", ";
-            }
-            std::cout << "\n";
-        }
+        ++found;
+        return !sink(grid);
     }
-    else
+
+    int row = cell / N, col = cell % N;
+    int subgrid = (row / 3) * 3 + col / 3;
+    int validCandidates = ~(rowMasks[row] | colMasks[col] | subgridMasks[subgrid]) & 0x1FF;
+
+    while (validCandidates)
     {
-        std::cout << "No solution found!\n";
+        int candidateBit = validCandidates & -validCandidates;
+
+        // Place the number
+        grid[row][col] = __builtin_ctz(candidateBit) + 1;
+        rowMasks[row] |= candidateBit;
+        colMasks[col] |= candidateBit;
+        subgridMasks[subgrid] |= candidateBit;
+
+        bool stop = enumerateRecursive(grid, context, cell + 1, sink, found);
+
+        // undo placing the number, on the way back from every solution as well as from dead ends
+        grid[row][col] = 0;
+        rowMasks[row] &= ~candidateBit;
+        colMasks[col] &= ~candidateBit;
+        subgridMasks[subgrid] &= ~candidateBit;
+
+        if (stop)
+            return true;
+        validCandidates &= (validCandidates - 1);
     }
 
-    return 0; // Indicates successful program termination
-}
\ No newline at end of file
+    return false;
+}
+
+long enumerateSolutions(int (&grid)[9][9], const SolutionSink &sink)
+{
+    // a repeated number means there is nothing to enumerate
+    SolverContext context;
+    if (!setGivenMasks(grid, context))
+        return 0;
+
+    long found = 0;
+    enumerateRecursive(grid, context, 0, sink, found);
+    return found;
+}
+
+bool sudokuSolver(int (&grid)[9][9])
+{
+    // every call gets its own masks on the stack, so any number of threads can solve at once
+    SolverContext context;
+    return sudokuSolver(grid, context);
+}
+
+} // namespace v3
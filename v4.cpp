@@ -1,271 +1,274 @@
 // Heuristics like MRV and LCV are used to solve the Sudoku puzzle.
+// the number of options of every cell and of every number in every row/col/grid are kept up to date as numbers
+// are placed and removed, so neither heuristic has to rescan the board
 
-#include <iostream> // Includes the standard input/output stream library
-#include <chrono>   // For timing
+#include <utility> // For std::pair
+#include "solvers.h"
+#include "stats.h"
 
-// Function to find the cell with the fewest valid options
-std::pair<int, int> findMostConstrainedCell(int grid[9][9], bool (&availableNumbers)[9][9][9])
+namespace v4
 {
-    int minOptions = INT_MAX;
-    std::pair<int, int> mostConstrainedCell = {-1, -1};
 
-    for (int row = 0; row < 9; ++row)
+struct Candidates
+{
+    bool availableNumbers[9][9][9];
+    int count[9][9];      // available numbers in each cell
+    int unitCount[27][9]; // empty cells of each row, col and 3x3 grid (in that order) that can still take each number
+
+    // empty cells in doubly linked lists by their count, filled cells are in no list (bucket -1)
+    int head[10];
+    int next[81], prev[81], bucket[81];
+};
+
+int subgridOf(int row, int col)
+{
+    return (row / 3) * 3 + col / 3;
+}
+
+void addToBucket(Candidates &candidates, int cell)
+{
+    int b = candidates.count[cell / 9][cell % 9];
+    candidates.bucket[cell] = b;
+    candidates.prev[cell] = -1;
+    candidates.next[cell] = candidates.head[b];
+    if (candidates.head[b] != -1)
+        candidates.prev[candidates.head[b]] = cell;
+    candidates.head[b] = cell;
+}
+
+void removeFromBucket(Candidates &candidates, int cell)
+{
+    int b = candidates.bucket[cell];
+    if (candidates.prev[cell] != -1)
+        candidates.next[candidates.prev[cell]] = candidates.next[cell];
+    else
+        candidates.head[b] = candidates.next[cell];
+    if (candidates.next[cell] != -1)
+        candidates.prev[candidates.next[cell]] = candidates.prev[cell];
+    candidates.bucket[cell] = -1;
+}
+
+// add (change 1) or take away (change -1) the cell's options from the counts of its row, col and grid
+void countCellOptions(Candidates &candidates, int row, int col, int change)
+{
+    for (int n = 0; n < 9; ++n)
     {
-        for (int col = 0; col < 9; ++col)
+        if (candidates.availableNumbers[row][col][n])
         {
-            if (grid[row][col] == 0)
-            { // Only consider empty cells
-                int validCount = 0;
-                for (int num = 0; num < 9; ++num)
-                {
-                    if (availableNumbers[row][col][num])
-                    {
-                        ++validCount;
-                    }
-                }
-
-                // Update the most constrained cell if fewer options are found
-                if (validCount < minOptions)
-                {
-                    minOptions = validCount;
-                    mostConstrainedCell = {row, col};
-                }
-            }
+            candidates.unitCount[row][n] += change;
+            candidates.unitCount[9 + col][n] += change;
+            candidates.unitCount[18 + subgridOf(row, col)][n] += change;
         }
     }
+}
+
+// flip one option of one cell and keep every count and bucket in step
+void setOption(Candidates &candidates, int row, int col, int n, bool available)
+{
+    int change = available ? 1 : -1;
+    candidates.availableNumbers[row][col][n] = available;
+    candidates.count[row][col] += change;
+
+    int cell = row * 9 + col;
+    if (candidates.bucket[cell] == -1)
+        return; // filled cells are not counted
+
+    candidates.unitCount[row][n] += change;
+    candidates.unitCount[9 + col][n] += change;
+    candidates.unitCount[18 + subgridOf(row, col)][n] += change;
+    removeFromBucket(candidates, cell);
+    addToBucket(candidates, cell);
+}
+
+// take an empty cell out of the counts before a number is placed in it
+void fillCell(Candidates &candidates, int row, int col)
+{
+    removeFromBucket(candidates, row * 9 + col);
+    countCellOptions(candidates, row, col, -1);
+}
 
-    return mostConstrainedCell;
+// put an emptied cell back into the counts once its options are restored
+void emptyCell(Candidates &candidates, int row, int col)
+{
+    countCellOptions(candidates, row, col, 1);
+    addToBucket(candidates, row * 9 + col);
+}
+
+// Function to find the cell with the fewest valid options, the first non empty bucket
+std::pair<int, int> findMostConstrainedCell(const Candidates &candidates)
+{
+    for (int b = 0; b < 10; ++b)
+        if (candidates.head[b] != -1)
+            return {candidates.head[b] / 9, candidates.head[b] % 9};
+
+    return {-1, -1};
 }
 
 // remove selected number from all available number lists in the same row, col, and 3x3 grid
-void removeNumberFromLists(bool (&availableNumbers)[9][9][9], int row, int col, int num)
+// returns which of the 27 row/col/grid slots actually changed so addNumberFromLists can undo exactly those
+int removeNumberFromLists(Candidates &candidates, int row, int col, int num)
 {
+    STATS_INC(propagations);
+    bool (&availableNumbers)[9][9][9] = candidates.availableNumbers;
+    int removed = 0;
+
     // check row
     for (int i = 0; i < 9; i++)
-        availableNumbers[i][col][num - 1] = false;
+        if (availableNumbers[i][col][num - 1])
+        {
+            setOption(candidates, i, col, num - 1, false);
+            removed |= 1 << i;
+        }
 
     // check col
     for (int i = 0; i < 9; i++)
-        availableNumbers[row][i][num - 1] = false;
+        if (availableNumbers[row][i][num - 1])
+        {
+            setOption(candidates, row, i, num - 1, false);
+            removed |= 1 << (9 + i);
+        }
 
     // check 3x3 grid
     int startRow = row - row % 3, startCol = col - col % 3;
     for (int i = 0; i < 3; ++i)
         for (int j = 0; j < 3; ++j)
-            availableNumbers[startRow + i][startCol + j][num - 1] = false;
+            if (availableNumbers[startRow + i][startCol + j][num - 1])
+            {
+                setOption(candidates, startRow + i, startCol + j, num - 1, false);
+                removed |= 1 << (18 + i * 3 + j);
+            }
+
+    return removed;
 }
 
-// add selected number to all available number lists in the same row, col, and 3x3 grid
-void addNumberFromLists(bool (&availableNumbers)[9][9][9], int row, int col, int num)
+// add selected number back to the lists it was removed from in the same row, col, and 3x3 grid
+// only the slots in removed are restored, the others are still blocked by some other placed number
+void addNumberFromLists(Candidates &candidates, int row, int col, int num, int removed)
 {
     // check row
     for (int i = 0; i < 9; i++)
-        availableNumbers[i][col][num - 1] = true;
+        if (removed & (1 << i))
+            setOption(candidates, i, col, num - 1, true);
 
     // check col
     for (int i = 0; i < 9; i++)
-        availableNumbers[row][i][num - 1] = true;
+        if (removed & (1 << (9 + i)))
+            setOption(candidates, row, i, num - 1, true);
 
     // check 3x3 grid
     int startRow = row - row % 3, startCol = col - col % 3;
     for (int i = 0; i < 3; ++i)
         for (int j = 0; j < 3; ++j)
-            availableNumbers[startRow + i][startCol + j][num - 1] = true;
+            if (removed & (1 << (18 + i * 3 + j)))
+                setOption(candidates, startRow + i, startCol + j, num - 1, true);
 }
 
 // Function to get the least constraining value for a specific cell
-std::vector<int> getLeastConstrainingValues(int grid[9][9], bool (&availableNumbers)[9][9][9], int row, int col)
+// a number's impact is how many other empty cells in the same row, col and grid would lose it as an option
+// the numbers are written to values in order of impact (ascending) and the count is returned, nothing is allocated
+int getLeastConstrainingValues(const Candidates &candidates, int row, int col, int (&values)[9])
 {
-    std::vector<std::pair<int, int>> candidates; // Pair of (number, impact)
+    int impacts[9];
+    int count = 0;
+    int subgrid = subgridOf(row, col);
 
     for (int num = 1; num <= 9; ++num)
     {
-        if (availableNumbers[row][col][num - 1])
+        if (candidates.availableNumbers[row][col][num - 1])
         {
-            int impact = 0;
-
-            // remove it as an option for all other slots in the same row, col, and grid
-            removeNumberFromLists(availableNumbers, row, col, num);
-
-            // Calculate impact: count how many valid options are removed for neighbors
-            for (int i = 0; i < 9; ++i)
-            {
-                // Check row
-                if (grid[row][i] == 0)
-                {
-                    for (int n = 0; n < 9; ++n)
-                    {
-                        if (availableNumbers[row][i][n])
-                        {
-                            ++impact;
-                        }
-                    }
-                }
-
-                // Check column
-                if (grid[i][col] == 0)
-                {
-                    for (int n = 0; n < 9; ++n)
-                    {
-                        if (availableNumbers[i][col][n])
-                        {
-                            ++impact;
-                        }
-                    }
-                }
-            }
+            // the cell itself is counted once in each of its units
+            int impact = candidates.unitCount[row][num - 1] + candidates.unitCount[9 + col][num - 1] +
+                         candidates.unitCount[18 + subgrid][num - 1] - 3;
 
-            // Check subgrid
-            int startRow = row - row % 3, startCol = col - col % 3;
-            for (int i = 0; i < 3; ++i)
+            // insertion sort, at most 9 numbers so this beats any general sort
+            int i = count++;
+            while (i > 0 && impacts[i - 1] > impact)
             {
-                for (int j = 0; j < 3; ++j)
-                {
-                    if (grid[startRow + i][startCol + j] == 0)
-                    {
-                        for (int n = 0; n < 9; ++n)
-                        {
-                            if (availableNumbers[startRow + i][startCol + j][n])
-                            {
-                                ++impact;
-                            }
-                        }
-                    }
-                }
+                impacts[i] = impacts[i - 1];
+                values[i] = values[i - 1];
+                --i;
             }
-
-            // add it back to all the lists
-            addNumberFromLists(availableNumbers, row, col, num);
-
-            // Add the candidate number and its impact
-            candidates.push_back({num, impact});
+            impacts[i] = impact;
+            values[i] = num;
         }
     }
 
-    // Sort candidates by their impact (ascending)
-    std::sort(candidates.begin(), candidates.end(),
-              [](const std::pair<int, int> &a, const std::pair<int, int> &b)
-              {
-                  return a.second < b.second;
-              });
-
-    // Extract only the numbers
-    std::vector<int> values;
-    for (const auto &candidate : candidates)
-    {
-        values.push_back(candidate.first);
-    }
-
-    return values;
+    return count;
 }
 
-bool sudokuSolverRecursive(int (&grid)[9][9], bool (&availableNumbers)[9][9][9])
+bool sudokuSolverRecursive(int (&grid)[9][9], Candidates &candidates)
 {
+    STATS_INC(nodes);
+
     // Step 1: Find the most constrained cell (MRV)
-    auto [row, col] = findMostConstrainedCell(grid, availableNumbers);
+    auto [row, col] = findMostConstrainedCell(candidates);
     if (row == -1)
     {
         return true; // No empty cells left, puzzle solved
     }
 
     // Step 2: Get the least constraining values (LCV)
-    std::vector<int> values = getLeastConstrainingValues(grid, availableNumbers, row, col);
+    int values[9];
+    int valueCount = getLeastConstrainingValues(candidates, row, col, values);
 
     // Step 3: Try each value in the sorted order
-    for (int num : values)
+    fillCell(candidates, row, col);
+    for (int v = 0; v < valueCount; ++v)
     {
-        if (availableNumbers[row][col][num - 1])
-        {
-            grid[row][col] = num;
+        int num = values[v];
+        grid[row][col] = num;
 
-            // remove it as an option for all other slots in the same row, col, and grid
-            removeNumberFromLists(availableNumbers, row, col, num);
+        // remove it as an option for all other slots in the same row, col, and grid
+        int removed = removeNumberFromLists(candidates, row, col, num);
 
-            // Recursively solve
-            if (sudokuSolverRecursive(grid, availableNumbers))
-            {
-                return true;
-            }
-
-            // if it was not the correct number, add it back to all the lists, backtrack, and try something else
-            addNumberFromLists(availableNumbers, row, col, num);
-            grid[row][col] = 0;
+        // Recursively solve
+        if (sudokuSolverRecursive(grid, candidates))
+        {
+            return true;
         }
+
+        // if it was not the correct number, add it back to all the lists, backtrack, and try something else
+        STATS_INC(backtracks);
+        addNumberFromLists(candidates, row, col, num, removed);
+        grid[row][col] = 0;
     }
+    emptyCell(candidates, row, col);
 
     return false; // No solution found
-
-    // puzzle has been solved
-    return true;
 }
 
 bool sudokuSolver(int (&grid)[9][9])
 {
-    // loop through the board once to set the numbers to false that are not contained in the hashset
-    bool availableNumbers[9][9][9];
+    Candidates candidates;
 
-    // Set each element to true
+    // Set each element to true, with no cell in a bucket yet
     for (int row = 0; row < 9; ++row)
         for (int col = 0; col < 9; ++col)
+        {
             for (int index = 0; index < 9; index++)
-                availableNumbers[row][col][index] = true;
+                candidates.availableNumbers[row][col][index] = true;
+            candidates.count[row][col] = 9;
+            candidates.bucket[row * 9 + col] = -1;
+        }
+    for (int u = 0; u < 27; ++u)
+        for (int n = 0; n < 9; ++n)
+            candidates.unitCount[u][n] = 0;
+    for (int b = 0; b < 10; ++b)
+        candidates.head[b] = -1;
 
     // loop through the board once to remove the numbers from the available numbers lists that are already present in same row/col/3x3 grid
     for (int row = 0; row < 9; ++row)
         for (int col = 0; col < 9; ++col)
             if (grid[row][col] != 0)
-                removeNumberFromLists(availableNumbers, row, col, grid[row][col]);
+                removeNumberFromLists(candidates, row, col, grid[row][col]);
 
-    return sudokuSolverRecursive(grid, availableNumbers);
-}
+    // then count the options of every empty cell
+    for (int row = 0; row < 9; ++row)
+        for (int col = 0; col < 9; ++col)
+            if (grid[row][col] == 0)
+                emptyCell(candidates, row, col);
 
-int main()
-{
-    // set up inputs
-    // Unsolved Sudoku puzzle (0 represents empty cells)
-    int sudoku[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
-
-    // Record the start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Call the function
-    bool solved = sudokuSolver(sudoku);
-
-    // Record the end time
-    auto end = std::chrono::high_resolution_clock::now();
-
-    // Calculate the duration in milliseconds
-    std::chrono::duration<double, std::milli> elapsed = end - start;
-
-    // Output the time taken in milliseconds
-    std::cout << "Execution time: " << elapsed.count() << " milliseconds\n"
-              << std::endl;
-
-    // output solved sudoku if it was solved
-    if (solved)
-    {
-        for (int row = 0; row < 9; ++row)
-        {
-            for (int col = 0; col < 9; ++col)
-            {
-                std::cout << sudoku[row][col] << ", ";
-            }
-            std::cout << "\n";
-        }
-    }
-    else
-    {
-        std::cout << "No solution found!\n";
-    }
+    return sudokuSolverRecursive(grid, candidates);
+}
 
-    return 0; // Indicates successful program termination
-}
\ No newline at end of file
+} // namespace v4
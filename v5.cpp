@@ -1,80 +1,114 @@
 // AC-3
-#include <vector>
-#include <queue>
-#include <set>
-#include <utility>  // For std::pair
-#include <iostream> // Includes the standard input/output stream library
-#include <chrono>   // For timing
-
-// Check if two variables (cells) are in conflict
-bool inConflict(int row1, int col1, int row2, int col2)
+// every constraint is "not equal" between a cell and one of its 20 peers, so an arc can only remove a value
+// when the other cell is down to a single value. Domains are 9 bit masks and the arcs come from peers.h.
+#include <cstdint> // For uint16_t/uint64_t
+#include "solvers.h"
+#include "stats.h"
+#include "peers.h"
+
+namespace v5
 {
-    return row1 == row2 || col1 == col2 || (row1 / 3 == row2 / 3 && col1 / 3 == col2 / 3);
-}
 
-// Reduce the domain of `A` based on the domain of `B`
-bool revise(std::vector<std::set<int>> &domains, int A, int B)
+const int arcCount = 81 * 20; // arc (A, k) constrains cell A by its k-th peer
+
+// position of each cell in the peer list of each of its peers, so the arc pointing back can be found
+struct ReverseArcs
 {
-    bool revised = false;
-    auto &domainA = domains[A];
-    const auto &domainB = domains[B];
+    int slot[81][20];
 
-    // Check if a value in A has no supporting value in B
-    for (auto it = domainA.begin(); it != domainA.end();)
+    constexpr ReverseArcs() : slot()
     {
-        bool supported = false;
-        for (int value : domainB)
+        for (int a = 0; a < 81; ++a)
         {
-            if (*it != value)
+            for (int k = 0; k < 20; ++k)
             {
-                supported = true;
-                break;
+                int b = peerTables.peers[a][k];
+                for (int j = 0; j < 20; ++j)
+                    if (peerTables.peers[b][j] == a)
+                        slot[a][k] = j;
             }
         }
-
-        if (!supported)
-        {
-            it = domainA.erase(it);
-            revised = true;
-        }
-        else
-        {
-            ++it;
-        }
     }
+};
+
+constexpr ReverseArcs reverseArcs;
+
+bool isSingle(uint16_t domain)
+{
+    return (domain & (domain - 1)) == 0;
+}
+
+// Reduce the domain of `A` based on the domain of `B`
+// A value in A only lacks support when B holds nothing but that value
+bool revise(uint16_t (&domains)[81], int A, int B)
+{
+    STATS_INC(revisions);
+
+    if (!isSingle(domains[B]) || !(domains[A] & domains[B]))
+        return false;
 
-    return revised;
+    domains[A] &= ~domains[B];
+    return true;
 }
 
-bool ac3(std::vector<std::set<int>> &domains, const std::vector<std::pair<int, int>> &constraints)
+// arcs waiting to be revised, each arc is in the queue at most once
+struct ArcQueue
 {
-    std::queue<std::pair<int, int>> queue;
+    int arcs[arcCount]; // ring buffer, never holds more than every arc
+    int head = 0, size = 0;
+    uint64_t queued[(arcCount + 63) / 64] = {};
 
-    // Add all constraints to the queue
-    for (const auto &constraint : constraints)
+    void push(int arc)
     {
-        queue.push(constraint);
+        uint64_t bit = uint64_t(1) << (arc & 63);
+        if (queued[arc >> 6] & bit)
+            return;
+        queued[arc >> 6] |= bit;
+        arcs[(head + size++) % arcCount] = arc;
+        STATS_INC(arcPushes);
     }
 
+    int pop()
+    {
+        int arc = arcs[head];
+        head = (head + 1) % arcCount;
+        --size;
+        queued[arc >> 6] &= ~(uint64_t(1) << (arc & 63));
+        return arc;
+    }
+};
+
+bool ac3(uint16_t (&domains)[81])
+{
+    ArcQueue queue;
+
+    // Add the constraints to the queue, an arc towards a cell with more than one value can never revise
+    // so only the arcs towards single values go in, the rest are added when their cell becomes single
+    for (int B = 0; B < 81; ++B)
+        if (isSingle(domains[B]))
+            for (int k = 0; k < 20; ++k)
+                queue.push(peerTables.peers[B][k] * 20 + reverseArcs.slot[B][k]);
+
     // Process the queue
-    while (!queue.empty())
+    while (queue.size > 0)
     {
-        auto [A, B] = queue.front();
-        queue.pop();
+        int arc = queue.pop();
+        int A = arc / 20, B = peerTables.peers[A][arc % 20];
 
         if (revise(domains, A, B))
         {
-            if (domains[A].empty())
+            if (domains[A] == 0)
             {
                 return false; // No solution
             }
 
-            // Add related constraints back to the queue
-            for (int i = 0; i < 81; ++i)
+            // only a single value in A can take anything out of its peers
+            if (isSingle(domains[A]))
             {
-                if (i != A && inConflict(A / 9, A % 9, i / 9, i % 9))
+                for (int k = 0; k < 20; ++k)
                 {
-                    queue.push({i, A});
+                    int peer = peerTables.peers[A][k];
+                    queue.push(peer * 20 + reverseArcs.slot[A][k]);
                 }
             }
         }
@@ -86,97 +120,31 @@ bool ac3(std::vector<std::set<int>> &domains, const std::vector<std::pair<int, i
 bool sudokuSolver(int (&grid)[9][9])
 {
     // Step 1: Initialize domains
-    std::vector<std::set<int>> domains(81);
+    uint16_t domains[81];
     for (int i = 0; i < 81; ++i)
     {
-        int row = i / 9, col = i % 9;
-        if (grid[row][col] == 0)
-        {
-            domains[i] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
-        }
-        else
-        {
-            domains[i] = {grid[row][col]};
-        }
-    }
-
-    // Step 2: Create constraints
-    std::vector<std::pair<int, int>> constraints;
-    for (int i = 0; i < 81; ++i)
-    {
-        for (int j = 0; j < 81; ++j)
-        {
-            if (i != j && inConflict(i / 9, i % 9, j / 9, j % 9))
-            {
-                constraints.emplace_back(i, j);
-            }
-        }
+        int value = grid[i / 9][i % 9];
+        if (value < 0 || value > 9)
+            return false;
+        domains[i] = value == 0 ? 0x1FF : 1 << (value - 1);
     }
 
-    // Step 3: Apply AC-3
-    if (!ac3(domains, constraints))
+    // Step 2: Apply AC-3
+    if (!ac3(domains))
     {
         return false; // No solution
     }
 
-    // Step 4: Fill the grid with solved values
+    // Step 3: Fill the grid with solved values
     for (int i = 0; i < 81; ++i)
     {
-        if (domains[i].size() == 1)
+        if (isSingle(domains[i]))
         {
-            grid[i / 9][i % 9] = *domains[i].begin();
+            grid[i / 9][i % 9] = __builtin_ctz(domains[i]) + 1;
         }
     }
 
     return true;
 }
 
-int main()
-{
-    // set up inputs
-    // Unsolved Sudoku puzzle (0 represents empty cells)
-    int sudoku[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
-
-    // Record the start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Call the function
-    bool solved = sudokuSolver(sudoku);
-
-    // Record the end time
-    auto end = std::chrono::high_resolution_clock::now();
-
-    // Calculate the duration in milliseconds
-    std::chrono::duration<double, std::milli> elapsed = end - start;
-
-    // Output the time taken in milliseconds
-    std::cout << "Execution time: " << elapsed.count() << " milliseconds\n"
-              << std::endl;
-
-    // output solved sudoku if it was solved
-    if (solved)
-    {
-        for (int row = 0; row < 9; ++row)
-        {
-            for (int col = 0; col < 9; ++col)
-            {
-                std::cout << sudoku[row][col] << ", ";
-            }
-            std::cout << "\n";
-        }
-    }
-    else
-    {
-        std::cout << "No solution found!\n";
-    }
-    return 0; // Indicates successful program termination
-}
\ No newline at end of file
+} // namespace v5
@@ -1,158 +1,127 @@
 // AC-3 and backtracking algorithm for solving Sudoku puzzles
+// domains are 9 bit masks in one flat array, and every reduction is written to a trail so a failed branch
+// undoes only what it changed instead of copying all the domains
 
-#include <vector>
-#include <queue>
-#include <set>
-#include <utility>  // For std::pair
-#include <iostream> // Includes the standard input/output stream library
-#include <chrono>   // For timing
+#include <cstdint> // For uint16_t
+#include "solvers.h"
+#include "stats.h"
+#include "peers.h"
 
-using namespace std;
+namespace v6
+{
 
-typedef vector<vector<set<int>>> Domains;
+// every reduction takes at least one of a cell's 9 values away, so one path never needs more
+const int trailSize = 81 * 9;
 
-bool isValid(int (&grid)[9][9], int row, int col, int num)
+struct State
 {
-    for (int i = 0; i < 9; ++i)
-    {
-        if (grid[row][i] == num || grid[i][col] == num)
-            return false;
-    }
+    uint16_t domains[81];
 
-    int startRow = row - row % 3, startCol = col - col % 3;
-    for (int i = 0; i < 3; ++i)
-    {
-        for (int j = 0; j < 3; ++j)
-        {
-            if (grid[startRow + i][startCol + j] == num)
-                return false;
-        }
-    }
+    // cell and old domain of every reduction, newest last
+    int trailCells[trailSize];
+    uint16_t trailDomains[trailSize];
+    int trailTop = 0;
+};
 
-    return true;
+bool isSingle(uint16_t domain)
+{
+    return (domain & (domain - 1)) == 0;
 }
 
-bool removeInconsistentValues(Domains &domains, int xiRow, int xiCol, int xjRow, int xjCol)
+void reduce(State &state, int cell, uint16_t domain)
 {
-    bool removed = false;
-    for (auto it = domains[xiRow][xiCol].begin(); it != domains[xiRow][xiCol].end();)
-    {
-        int value = *it;
-        // Check if there's any valid value in xj's domain that satisfies the "not-equal" constraint
-        bool isConsistent = false;
-        for (int neighborValue : domains[xjRow][xjCol])
-        {
-            if (value != neighborValue)
-            {
-                isConsistent = true;
-                break;
-            }
-        }
+    state.trailCells[state.trailTop] = cell;
+    state.trailDomains[state.trailTop] = state.domains[cell];
+    ++state.trailTop;
+    state.domains[cell] = domain;
+}
 
-        if (!isConsistent)
-        {
-            it = domains[xiRow][xiCol].erase(it);
-            removed = true;
-        }
-        else
-        {
-            ++it;
-        }
+// put back every domain changed since the trail was at mark
+void undo(State &state, int mark)
+{
+    while (state.trailTop > mark)
+    {
+        --state.trailTop;
+        state.domains[state.trailCells[state.trailTop]] = state.trailDomains[state.trailTop];
     }
-    return removed;
 }
 
-bool ac3(Domains &domains)
+// "not equal" only rules out a value of xi when xj is down to that one value
+bool removeInconsistentValues(State &state, int xi, int xj)
+{
+    STATS_INC(revisions);
+
+    uint16_t neighbor = state.domains[xj];
+    if (!isSingle(neighbor) || !(state.domains[xi] & neighbor))
+        return false;
+
+    reduce(state, xi, state.domains[xi] & ~neighbor);
+    return true;
+}
+
+// queue holds the cells whose single value has to be checked against their peers, count of them to start with
+// an arc (peer, cell) can only remove something once cell is single, so cells stand in for their 20 arcs
+bool ac3(State &state, int (&queue)[81], int count)
 {
-    queue<pair<pair<int, int>, pair<int, int>>> arcs;
+    STATS_ADD(arcPushes, count * 20);
 
-    // Initialize arcs with all cell pairs
-    for (int row = 0; row < 9; ++row)
+    for (int head = 0; head < count; ++head)
     {
-        for (int col = 0; col < 9; ++col)
+        int xj = queue[head];
+        for (int xi : peerTables.peers[xj])
         {
-            if (!domains[row][col].empty())
+            if (removeInconsistentValues(state, xi, xj))
             {
-                for (int i = 0; i < 9; ++i)
-                {
-                    if (i != col)
-                        arcs.push({{row, col}, {row, i}}); // Same row
-                    if (i != row)
-                        arcs.push({{row, col}, {i, col}}); // Same column
-                }
+                if (state.domains[xi] == 0)
+                    return false;
 
-                int startRow = row - row % 3, startCol = col - col % 3;
-                for (int i = 0; i < 3; ++i)
+                // a cell only becomes single once, so the queue never holds more than 81
+                if (isSingle(state.domains[xi]))
                 {
-                    for (int j = 0; j < 3; ++j)
-                    {
-                        int r = startRow + i, c = startCol + j;
-                        if (r != row || c != col)
-                            arcs.push({{row, col}, {r, c}});
-                    }
+                    queue[count++] = xi;
+                    STATS_ADD(arcPushes, 20);
                 }
             }
         }
     }
 
-    while (!arcs.empty())
-    {
-        auto [xi, xj] = arcs.front();
-        arcs.pop();
-
-        if (removeInconsistentValues(domains, xi.first, xi.second, xj.first, xj.second))
-        {
-            if (domains[xi.first][xi.second].empty())
-                return false;
-
-            for (int i = 0; i < 9; ++i)
-            {
-                if (i != xi.second)
-                    arcs.push({{xi.first, xi.second}, {xi.first, i}});
-                if (i != xi.first)
-                    arcs.push({{xi.first, xi.second}, {i, xi.second}});
-            }
-        }
-    }
-
     return true;
 }
 
-bool sudokuSolverRecursive(Domains &domains, int (&grid)[9][9])
+bool sudokuSolverRecursive(State &state)
 {
+    STATS_INC(nodes);
+
     // Find the cell with the smallest domain (Most Constrained Variable)
-    int row = -1, col = -1, minDomainSize = 10;
-    for (int i = 0; i < 9; ++i)
+    int cell = -1, minDomainSize = 10;
+    for (int i = 0; i < 81 && minDomainSize > 2; ++i)
     {
-        for (int j = 0; j < 9; ++j)
+        int size = __builtin_popcount(state.domains[i]);
+        if (size > 1 && size < minDomainSize)
         {
-            if (grid[i][j] == 0 && domains[i][j].size() < minDomainSize)
-            {
-                row = i;
-                col = j;
-                minDomainSize = domains[i][j].size();
-            }
+            cell = i;
+            minDomainSize = size;
         }
     }
 
-    // If no empty cell is found, the puzzle is solved
-    if (row == -1)
+    // If every domain is down to one value, the puzzle is solved
+    if (cell == -1)
         return true;
 
     // Try each value in the domain
-    auto backupDomains = domains; // Backup domains for backtracking
-    for (int value : domains[row][col])
+    int mark = state.trailTop;
+    for (uint16_t values = state.domains[cell]; values; values &= values - 1)
     {
-        grid[row][col] = value;
-
         // Propagate constraints using AC-3
-        domains[row][col] = {value};
-        if (ac3(domains) && sudokuSolverRecursive(domains, grid))
+        int queue[81];
+        queue[0] = cell;
+        reduce(state, cell, values & -values);
+        if (ac3(state, queue, 1) && sudokuSolverRecursive(state))
             return true;
 
         // Backtrack
-        domains = backupDomains;
-        grid[row][col] = 0;
+        STATS_INC(backtracks);
+        undo(state, mark);
     }
 
     return false;
@@ -161,85 +130,25 @@ bool sudokuSolverRecursive(Domains &domains, int (&grid)[9][9])
 bool sudokuSolver(int (&grid)[9][9])
 {
     // Initialize domains
-    Domains domains(9, vector<set<int>>(9));
-    for (int row = 0; row < 9; ++row)
+    State state;
+    int queue[81], count = 0;
+    for (int i = 0; i < 81; ++i)
     {
-        for (int col = 0; col < 9; ++col)
-        {
-            if (grid[row][col] == 0)
-            {
-                for (int value = 1; value <= 9; ++value)
-                {
-                    if (isValid(grid, row, col, value))
-                    {
-                        domains[row][col].insert(value);
-                    }
-                }
-            }
-            else
-            {
-                domains[row][col] = {grid[row][col]};
-            }
-        }
+        int value = grid[i / 9][i % 9];
+        if (value < 0 || value > 9)
+            return false;
+        state.domains[i] = value == 0 ? 0x1FF : 1 << (value - 1);
+        if (value != 0)
+            queue[count++] = i;
     }
 
     // Preprocess with AC-3
-    if (!ac3(domains))
-    {
-        cout << "No solution exists!" << endl;
-        return 0;
-    }
+    if (!ac3(state, queue, count) || !sudokuSolverRecursive(state))
+        return false; // No solution
 
-    return sudokuSolverRecursive(domains, grid);
+    for (int i = 0; i < 81; ++i)
+        grid[i / 9][i % 9] = __builtin_ctz(state.domains[i]) + 1;
+    return true;
 }
 
-int main()
-{
-    // set up inputs
-    // Unsolved Sudoku puzzle (0 represents empty cells)
-    int sudoku[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
-
-    // Record the start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Call the function
-    bool solved = sudokuSolver(sudoku);
-
-    // Record the end time
-    auto end = std::chrono::high_resolution_clock::now();
-
-    // Calculate the duration in milliseconds
-    std::chrono::duration<double, std::milli> elapsed = end - start;
-
-    // Output the time taken in milliseconds
-    std::cout << "Execution time: " << elapsed.count() << " milliseconds\n"
-              << std::endl;
-
-    // output solved sudoku if it was solved
-    if (solved)
-    {
-        for (int row = 0; row < 9; ++row)
-        {
-            for (int col = 0; col < 9; ++col)
-            {
-                std::cout << sudoku[row][col] << ", ";
-            }
-            std::cout << "\n";
-        }
-    }
-    else
-    {
-        std::cout << "No solution found!\n";
-    }
-
-    return 0; // Indicates successful program termination
-}
\ No newline at end of file
+} // namespace v6
@@ -1,147 +1,403 @@
 // using multithreading
+// a fixed pool of workers searches the tree together, each worker keeps its own deque of subtrees
+// and idle workers steal from the others, subtrees are only split off near the root
 
-#include <iostream>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include "solvers.h"
+#include "stats.h"
+
+namespace v7
+{
 
 using namespace std;
 
-bool isValid(int (&grid)[9][9], int row, int col, int num)
+const int splitDepth = 6;       // branch points shallower than this hand their other candidates out as tasks
+const int dequeCapacity = 1024; // per worker, must be a power of two
+const int maxTasks = 1 << 14;   // task boards preallocated for one solve
+
+// one search node, the grid plus bitmasks of the numbers used in each row, column and 3x3 grid
+struct Board
 {
-    // Check the row
-    for (int x = 0; x < 9; ++x)
+    unsigned char cells[81];
+    unsigned short rowMasks[9];
+    unsigned short colMasks[9];
+    unsigned short subgridMasks[9];
+    int depth; // branch points above this node
+};
+
+// Chase-Lev work-stealing deque, the owner pushes and takes at the bottom and thieves steal from the top
+// memory orders follow the C11 version by Le, Pop, Cohen and Zappa Nardelli (PPoPP 2013)
+class WorkDeque
+{
+public:
+    // only called while no other thread is touching the deque
+    void reset()
     {
-        if (grid[row][x] == num)
-            return false;
+        top.store(0, memory_order_relaxed);
+        bottom.store(0, memory_order_relaxed);
     }
 
-    // Check the column
-    for (int x = 0; x < 9; ++x)
+    // owner only, false when the deque is full
+    bool push(Board *task)
     {
-        if (grid[x][col] == num)
+        long b = bottom.load(memory_order_relaxed);
+        long t = top.load(memory_order_acquire);
+        if (b - t >= dequeCapacity)
             return false;
+
+        buffer[b & (dequeCapacity - 1)].store(task, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        bottom.store(b + 1, memory_order_relaxed);
+        return true;
     }
 
-    // Check the 3x3 subgrid
-    int startRow = row - row % 3;
-    int startCol = col - col % 3;
-    for (int i = 0; i < 3; ++i)
+    // owner only, newest task first so the owner keeps working depth first
+    Board *take()
     {
-        for (int j = 0; j < 3; ++j)
+        long b = bottom.load(memory_order_relaxed) - 1;
+        bottom.store(b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        long t = top.load(memory_order_relaxed);
+
+        Board *task = nullptr;
+        if (t <= b)
         {
-            if (grid[startRow + i][startCol + j] == num)
-                return false;
+            task = buffer[b & (dequeCapacity - 1)].load(memory_order_relaxed);
+            if (t == b)
+            {
+                // last task, race the thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                    task = nullptr;
+                bottom.store(b + 1, memory_order_relaxed);
+            }
         }
+        else
+        {
+            bottom.store(b + 1, memory_order_relaxed);
+        }
+        return task;
     }
 
-    return true;
-}
-
-// Function to solve Sudoku using backtracking with multithreading
-bool parallelSudokuSolver(int (&grid)[9][9], int row, int col)
-{
-    if (row == 9)
-        return true; // Solved
-    if (col == 9)
-        return parallelSudokuSolver(grid, row + 1, 0); // Move to next row
-    if (grid[row][col] != 0)
-        return parallelSudokuSolver(grid, row, col + 1); // Skip filled cells
-
-    vector<thread> threads;
-    atomic<bool> solved(false);
-    mutex gridLock;
-
-    for (int num = 1; num <= 9; ++num)
+    // any thread, oldest task first since those are the biggest subtrees
+    Board *steal()
     {
-        if (isValid(grid, row, col, num))
-        {
-            threads.emplace_back([&, num]()
-                                 {
-                // Local copy of the grid to avoid conflicts
-                int localGrid[9][9];
-                {
-                    lock_guard<mutex> lock(gridLock);
-                    copy(&grid[0][0], &grid[0][0] + 81, &localGrid[0][0]);
-                }
+        long t = top.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        long b = bottom.load(memory_order_acquire);
 
-                // Place the number
-                localGrid[row][col] = num;
-
-                // Recursively solve the rest of the grid
-                if (parallelSudokuSolver(localGrid, row, col + 1)) {
-                    lock_guard<mutex> lock(gridLock);
-                    if (!solved) {
-                        copy(&localGrid[0][0], &localGrid[0][0] + 81, &grid[0][0]);
-                        solved = true;
-                    }
-                } });
+        if (t < b)
+        {
+            Board *task = buffer[t & (dequeCapacity - 1)].load(memory_order_relaxed);
+            if (top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                return task;
         }
+        return nullptr;
     }
 
-    // Wait for all threads to finish
-    for (auto &t : threads)
+private:
+    alignas(64) atomic<long> top{0};
+    alignas(64) atomic<long> bottom{0};
+    atomic<Board *> buffer[dequeCapacity];
+};
+
+class SearchPool
+{
+public:
+    // the thread calling solve is worker 0, the pool starts the other workers once and keeps them
+    explicit SearchPool(int workerCount) : deques(workerCount), tasks(maxTasks)
     {
-        if (t.joinable())
+        for (int id = 1; id < workerCount; ++id)
+            helpers.emplace_back(&SearchPool::helperLoop, this, id);
+    }
+
+    ~SearchPool()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &t : helpers)
             t.join();
     }
 
-    return solved;
-}
+    bool solve(int (&grid)[9][9])
+    {
+        // the pool's boards and deques belong to one solve at a time
+        lock_guard<mutex> oneSolve(solveLock);
 
-bool sudokuSolver(int (&grid)[9][9])
-{
-    return parallelSudokuSolver(grid, 0, 0);
-}
+        Board root;
+        root.depth = 0;
+        for (int i = 0; i < 9; ++i)
+            root.rowMasks[i] = root.colMasks[i] = root.subgridMasks[i] = 0;
 
-int main()
-{
-    // set up inputs
-    // Unsolved Sudoku puzzle (0 represents empty cells)
-    int sudoku[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
-
-    // Record the start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Call the function
-    bool solved = sudokuSolver(sudoku);
-
-    // Record the end time
-    auto end = std::chrono::high_resolution_clock::now();
-
-    // Calculate the duration in milliseconds
-    std::chrono::duration<double, std::milli> elapsed = end - start;
-
-    // Output the time taken in milliseconds
-    std::cout << "Execution time: " << elapsed.count() << " milliseconds\n"
-              << std::endl;
-
-    // output solved sudoku if it was solved
-    if (solved)
-    {
         for (int row = 0; row < 9; ++row)
         {
             for (int col = 0; col < 9; ++col)
             {
-                std::cout << sudoku[row][col] << ", ";
+                int value = grid[row][col];
+                if (value < 0 || value > 9)
+                    return false;
+                root.cells[row * 9 + col] = value;
+                if (value == 0)
+                    continue;
+
+                int bit = 1 << (value - 1);
+                int subgrid = (row / 3) * 3 + col / 3;
+                if ((root.rowMasks[row] | root.colMasks[col] | root.subgridMasks[subgrid]) & bit)
+                    return false; // clues already conflict
+                root.rowMasks[row] |= bit;
+                root.colMasks[col] |= bit;
+                root.subgridMasks[subgrid] |= bit;
+            }
+        }
+
+        for (auto &deque : deques)
+            deque.reset();
+        taskCount.store(1, memory_order_relaxed);
+        tasks[0] = root;
+        pending.store(1, memory_order_relaxed);
+        solved.store(false, memory_order_relaxed);
+        deques[0].push(&tasks[0]);
+
+        // let the helpers in
+        {
+            lock_guard<mutex> guard(lock);
+            ++generation;
+            running = true;
+        }
+        wake.notify_all();
+
+        runTasks(0);
+
+        // no helper may still be reading the boards once we return
+        {
+            unique_lock<mutex> guard(lock);
+            running = false;
+            done.wait(guard, [this]
+                      { return activeHelpers == 0; });
+#ifdef SUDOKU_STATS
+            solverStats += helperStats;
+            helperStats = SolverStats();
+#endif
+        }
+
+        if (!solved.load(memory_order_relaxed))
+            return false;
+
+        for (int i = 0; i < 81; ++i)
+            grid[i / 9][i % 9] = solution[i];
+        return true;
+    }
+
+private:
+    vector<WorkDeque> deques;
+    vector<Board> tasks;
+    vector<thread> helpers;
+    atomic<int> taskCount{0};
+    atomic<long> pending{0}; // tasks handed out but not finished yet
+    atomic<bool> solved{false};
+    unsigned char solution[81];
+
+    mutex solveLock;
+    mutex lock;
+    condition_variable wake;
+    condition_variable done;
+    long generation = 0;
+    bool running = false;
+    bool stopping = false;
+    int activeHelpers = 0;
+#ifdef SUDOKU_STATS
+    SolverStats helperStats; // counters of the helpers, added to the solving thread's once they have checked out
+#endif
+
+    void helperLoop(int id)
+    {
+        long seen = 0;
+        while (true)
+        {
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&]
+                          { return stopping || (running && generation != seen); });
+                if (stopping)
+                    return;
+                seen = generation;
+                ++activeHelpers;
             }
-            std::cout << "\n";
+
+            runTasks(id);
+
+            {
+                lock_guard<mutex> guard(lock);
+#ifdef SUDOKU_STATS
+                helperStats += solverStats;
+                solverStats = SolverStats();
+#endif
+                --activeHelpers;
+            }
+            done.notify_all();
         }
     }
-    else
+
+    // work until a solution is found or every task has been searched
+    void runTasks(int id)
     {
-        std::cout << "No solution found!\n";
+        unsigned seed = id * 2654435761u + 1;
+        int workers = deques.size();
+
+        while (!solved.load(memory_order_relaxed) && pending.load(memory_order_acquire) > 0)
+        {
+            Board *task = deques[id].take();
+
+            // own deque is empty, try the others starting at a random victim
+            for (int attempt = 0; task == nullptr && attempt < workers; ++attempt)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                int victim = seed % workers;
+                if (victim != id)
+                    task = deques[victim].steal();
+            }
+
+            if (task == nullptr)
+            {
+                this_thread::yield();
+                continue;
+            }
+
+            Board board = *task;
+            search(board, id);
+            pending.fetch_sub(1, memory_order_release);
+        }
+    }
+
+    void place(Board &board, int cell, int bit)
+    {
+        int row = cell / 9, col = cell % 9;
+        board.cells[cell] = __builtin_ctz(bit) + 1;
+        board.rowMasks[row] |= bit;
+        board.colMasks[col] |= bit;
+        board.subgridMasks[(row / 3) * 3 + col / 3] |= bit;
+    }
+
+    void unplace(Board &board, int cell, int bit)
+    {
+        int row = cell / 9, col = cell % 9;
+        board.cells[cell] = 0;
+        board.rowMasks[row] &= ~bit;
+        board.colMasks[col] &= ~bit;
+        board.subgridMasks[(row / 3) * 3 + col / 3] &= ~bit;
+    }
+
+    bool search(Board &board, int id)
+    {
+        STATS_INC(nodes);
+
+        // another worker already finished the puzzle
+        if (solved.load(memory_order_relaxed))
+            return false;
+
+        // pick the empty cell with the fewest candidates
+        int bestCell = -1, bestCandidates = 0, bestCount = 10;
+        for (int cell = 0; cell < 81; ++cell)
+        {
+            if (board.cells[cell] != 0)
+                continue;
+
+            int row = cell / 9, col = cell % 9;
+            int candidates = ~(board.rowMasks[row] | board.colMasks[col] | board.subgridMasks[(row / 3) * 3 + col / 3]) & 0x1FF;
+            int count = __builtin_popcount(candidates);
+            if (count < bestCount)
+            {
+                bestCell = cell;
+                bestCandidates = candidates;
+                bestCount = count;
+                if (count <= 1)
+                    break;
+            }
+        }
+
+        // every cell is filled, the first worker here owns the solution
+        if (bestCell == -1)
+        {
+            if (!solved.exchange(true, memory_order_acq_rel))
+                copy(board.cells, board.cells + 81, solution);
+            return true;
+        }
+
+        if (bestCount == 0)
+            return false;
+
+        // near the root, hand every candidate but the first to the pool
+        if (bestCount > 1 && board.depth < splitDepth)
+        {
+            int first = bestCandidates & -bestCandidates;
+            for (int rest = bestCandidates & (bestCandidates - 1); rest; rest &= rest - 1)
+            {
+                int bit = rest & -rest;
+                int index = taskCount.fetch_add(1, memory_order_relaxed);
+                Board *child = index < maxTasks ? &tasks[index] : nullptr;
+
+                if (child != nullptr)
+                {
+                    *child = board;
+                    child->depth = board.depth + 1;
+                    place(*child, bestCell, bit);
+                    pending.fetch_add(1, memory_order_relaxed);
+                    if (deques[id].push(child))
+                        continue;
+                    pending.fetch_sub(1, memory_order_relaxed);
+                }
+
+                // out of task boards or deque space, search this one here
+                place(board, bestCell, bit);
+                board.depth++;
+                bool found = search(board, id);
+                board.depth--;
+                unplace(board, bestCell, bit);
+                if (found)
+                    return true;
+            }
+
+            place(board, bestCell, first);
+            board.depth++;
+            bool found = search(board, id);
+            board.depth--;
+            unplace(board, bestCell, first);
+            if (!found)
+                STATS_INC(backtracks);
+            return found;
+        }
+
+        // below the split depth it is a plain sequential search
+        int depth = board.depth;
+        if (bestCount > 1)
+            board.depth++;
+        for (int candidates = bestCandidates; candidates; candidates &= candidates - 1)
+        {
+            int bit = candidates & -candidates;
+            place(board, bestCell, bit);
+            if (search(board, id))
+                return true;
+            unplace(board, bestCell, bit);
+            STATS_INC(backtracks);
+        }
+        board.depth = depth;
+        return false;
     }
+};
+
+bool sudokuSolver(int (&grid)[9][9])
+{
+    // started on first use and kept for the life of the process
+    static SearchPool pool(max(1u, thread::hardware_concurrency()));
+    return pool.solve(grid);
+}
 
-    return 0; // Indicates successful program termination
-}
\ No newline at end of file
+} // namespace v7
@@ -1,67 +1,106 @@
-// using iterative deepening
+// using iterative deepening on discrepancies (limited discrepancy search)
+// every solution is exactly as deep as the number of empty cells, so deepening on depth only redoes work.
+// Instead iteration k only follows paths that go against the value ordering exactly k times, taking the lowest
+// candidate of a cell costs nothing and any other candidate costs one discrepancy. Easy puzzles are usually
+// solved in the first iterations and memory stays at one path, like any DFS.
 
-#include <iostream>
 #include <vector>
-#include <thread>
-#include <mutex>
-#include <atomic>
+#include <utility> // For std::pair
+#include "solvers.h"
+#include "stats.h"
+
+namespace v8
+{
 
 using namespace std;
 
-// Check if placing a number is valid
-bool isValid(int (&grid)[9][9], int row, int col, int num)
+// numbers used in each row, column and 3x3 grid, like v3
+struct Masks
 {
-    for (int x = 0; x < 9; ++x)
-    {
-        if (grid[row][x] == num || grid[x][col] == num)
-            return false;
-    }
-    int startRow = row - row % 3, startCol = col - col % 3;
-    for (int i = 0; i < 3; ++i)
-    {
-        for (int j = 0; j < 3; ++j)
-        {
-            if (grid[startRow + i][startCol + j] == num)
-                return false;
-        }
-    }
-    return true;
+    int rows[9], cols[9], subgrids[9];
+};
+
+int subgridOf(int row, int col)
+{
+    return (row / 3) * 3 + col / 3;
 }
 
-// Depth-limited DFS
-bool depthLimitedDFS(int (&grid)[9][9], vector<pair<int, int>> &emptyCells, int depthLimit, int currentDepth = 0)
+int candidatesOf(const Masks &masks, int row, int col)
 {
-    if (currentDepth == depthLimit)
-        return false; // Reached depth limit
+    return ~(masks.rows[row] | masks.cols[col] | masks.subgrids[subgridOf(row, col)]) & 0x1FF;
+}
+
+void toggle(Masks &masks, int row, int col, int bit)
+{
+    masks.rows[row] ^= bit;
+    masks.cols[col] ^= bit;
+    masks.subgrids[subgridOf(row, col)] ^= bit;
+}
+
+// emptyCells[0, depth) are filled in order, the rest are still empty
+// discrepancies is how many more times this path has to leave the value ordering, cutoff is set when a
+// value was skipped only because the budget ran out, so a larger budget would find more
+bool limitedDiscrepancySearch(int (&grid)[9][9], vector<pair<int, int>> &emptyCells, Masks &masks, size_t depth,
+                              int discrepancies, bool &cutoff)
+{
+    STATS_INC(nodes);
 
     // If all empty cells are filled, the puzzle is solved
-    if (emptyCells.empty())
+    if (depth == emptyCells.size())
         return true;
 
-    // Get the next empty cell
-    auto [row, col] = emptyCells.back();
-    emptyCells.pop_back();
+    // Move the empty cell with the fewest candidates to the front of what is left (MRV)
+    size_t best = depth;
+    int bestCount = 10;
+    for (size_t i = depth; i < emptyCells.size() && bestCount > 1; ++i)
+    {
+        int count = __builtin_popcount(candidatesOf(masks, emptyCells[i].first, emptyCells[i].second));
+        if (count < bestCount)
+        {
+            best = i;
+            bestCount = count;
+        }
+    }
+    if (bestCount == 0)
+        return false;
+    swap(emptyCells[depth], emptyCells[best]);
+
+    auto [row, col] = emptyCells[depth];
+    int remaining = emptyCells.size() - depth; // cells left including this one, each can add one discrepancy
 
-    // Try placing numbers 1-9
-    for (int num = 1; num <= 9; ++num)
+    // Try the candidates lowest first, every one after the first is a discrepancy
+    int candidates = candidatesOf(masks, row, col);
+    for (bool first = true; candidates; candidates &= candidates - 1, first = false)
     {
-        if (isValid(grid, row, col, num))
+        int budget = first ? discrepancies : discrepancies - 1;
+
+        // the first value needs the cells below it to use up the whole budget
+        if (first && remaining <= discrepancies)
+            continue;
+        if (budget < 0)
         {
-            grid[row][col] = num;
+            cutoff = true;
+            break;
+        }
 
-            // Recur with the next empty cell
-            if (depthLimitedDFS(grid, emptyCells, depthLimit, currentDepth + 1))
-            {
-                return true;
-            }
+        int bit = candidates & -candidates;
+        grid[row][col] = __builtin_ctz(bit) + 1;
+        toggle(masks, row, col, bit);
 
-            // Backtrack
-            grid[row][col] = 0;
+        // Recur with the next empty cell
+        if (limitedDiscrepancySearch(grid, emptyCells, masks, depth + 1, budget, cutoff))
+        {
+            return true;
         }
+
+        // Backtrack
+        STATS_INC(backtracks);
+        toggle(masks, row, col, bit);
+        grid[row][col] = 0;
     }
 
-    // Restore the empty cell
-    emptyCells.push_back({row, col});
+    // put the worklist back, so the next iteration meets the same cells in the same order
+    swap(emptyCells[depth], emptyCells[best]);
     return false;
 }
 
@@ -69,80 +108,48 @@ bool depthLimitedDFS(int (&grid)[9][9], vector<pair<int, int>> &emptyCells, int
 bool sudokuSolver(int (&grid)[9][9])
 {
     vector<pair<int, int>> emptyCells;
+    emptyCells.reserve(81);
+    Masks masks = {};
 
-    // Collect all empty cells
+    // Collect all empty cells and the numbers already placed
     for (int row = 0; row < 9; ++row)
     {
         for (int col = 0; col < 9; ++col)
         {
-            if (grid[row][col] == 0)
+            int value = grid[row][col];
+            if (value == 0)
             {
                 emptyCells.emplace_back(row, col);
             }
+            else
+            {
+                if (value < 0 || value > 9)
+                    return false;
+                int bit = 1 << (value - 1);
+                if ((candidatesOf(masks, row, col) & bit) == 0)
+                    return false; // the givens already clash
+                toggle(masks, row, col, bit);
+            }
         }
     }
 
-    // Iteratively increase the depth limit
-    for (int depthLimit = 1; depthLimit <= 81; ++depthLimit)
+    // Iteratively increase the number of discrepancies allowed
+    for (size_t discrepancies = 0; discrepancies <= emptyCells.size(); ++discrepancies)
     {
-        vector<pair<int, int>> tempEmptyCells = emptyCells;
+        STATS_INC(restarts);
+        bool cutoff = false;
 
-        if (depthLimitedDFS(grid, tempEmptyCells, depthLimit))
+        if (limitedDiscrepancySearch(grid, emptyCells, masks, 0, discrepancies, cutoff))
         {
             return true; // Solution found
         }
+
+        // nothing was skipped for lack of budget, so every path has been tried
+        if (!cutoff)
+            break;
     }
 
     return false; // No solution found
 }
 
-int main()
-{
-    // set up inputs
-    // Unsolved Sudoku puzzle (0 represents empty cells)
-    int sudoku[9][9] = {
-        {5, 3, 0, 0, 7, 0, 0, 0, 0},
-        {6, 0, 0, 1, 9, 5, 0, 0, 0},
-        {0, 9, 8, 0, 0, 0, 0, 6, 0},
-        {8, 0, 0, 0, 6, 0, 0, 0, 3},
-        {4, 0, 0, 8, 0, 3, 0, 0, 1},
-        {7, 0, 0, 0, 2, 0, 0, 0, 6},
-        {0, 6, 0, 0, 0, 0, 2, 8, 0},
-        {0, 0, 0, 4, 1, 9, 0, 0, 5},
-        {0, 0, 0, 0, 8, 0, 0, 7, 9}};
-
-    // Record the start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Call the function
-    bool solved = sudokuSolver(sudoku);
-
-    // Record the end time
-    auto end = std::chrono::high_resolution_clock::now();
-
-    // Calculate the duration in milliseconds
-    std::chrono::duration<double, std::milli> elapsed = end - start;
-
-    // Output the time taken in milliseconds
-    std::cout << "Execution time: " << elapsed.count() << " milliseconds\n"
-              << std::endl;
-
-    // output solved sudoku if it was solved
-    if (solved)
-    {
-        for (int row = 0; row < 9; ++row)
-        {
-            for (int col = 0; col < 9; ++col)
-            {
-                std::cout << sudoku[row][col] << ", ";
-            }
-            std::cout << "\n";
-        }
-    }
-    else
-    {
-        std::cout << "No solution found!\n";
-    }
-
-    return 0; // Indicates successful program termination
-}
\ No newline at end of file
+} // namespace v8
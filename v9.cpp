@@ -0,0 +1,232 @@
+// lockstep propagation over 16 puzzles at once, one puzzle per 16 bit lane of a vector
+// every cell holds a 9 bit candidate mask, and a sweep over the 27 rows, columns and 3x3 grids removes
+// placed numbers and fills hidden singles for all lanes with the same vector instructions
+// lanes that finish are refilled from the batch, lanes that stop making progress are finished by a scalar search
+
+#include "solvers.h"
+#include "stats.h"
+#include "peers.h"
+#include "lanes.h"
+
+namespace v9
+{
+
+// the candidate masks of 16 puzzles, cell by cell, so one vector holds the same cell of every puzzle
+struct LaneBoard
+{
+    Lanes cells[81];
+};
+
+// one sweep over every unit, marks the lanes that changed and the lanes with a contradiction
+// (the vectors go by reference, passing them by value would depend on whether AVX is enabled)
+void sweep(LaneBoard &board, Lanes &changed, Lanes &dead)
+{
+    for (int u = 0; u < 27; ++u)
+    {
+        const int *unit = peerTables.units[u];
+
+        // numbers seen once, seen more than once, placed, and placed twice (a contradiction)
+        Lanes once = {}, twice = {}, placed = {}, placedTwice = {};
+        for (int k = 0; k < 9; ++k)
+        {
+            Lanes c = board.cells[unit[k]];
+            Lanes single = (Lanes)((c & (c - 1)) == 0) & c;
+            twice |= once & c;
+            once |= c;
+            placedTwice |= placed & single;
+            placed |= single;
+        }
+        dead |= (Lanes)(once != 0x1FF) | placedTwice;
+
+        // a number that fits only one cell of the unit has to go there
+        Lanes hidden = once & ~twice & ~placed;
+
+        for (int k = 0; k < 9; ++k)
+        {
+            Lanes c = board.cells[unit[k]];
+            Lanes isSingle = (Lanes)((c & (c - 1)) == 0);
+            Lanes reduced = c & ~placed;
+            Lanes onlyHere = reduced & hidden;
+            Lanes useHidden = (Lanes)(onlyHere != 0);
+            reduced = (onlyHere & useHidden) | (reduced & ~useHidden);
+
+            Lanes updated = (c & isSingle) | (reduced & ~isSingle);
+            dead |= (Lanes)(updated == 0);
+            changed |= updated ^ c;
+            board.cells[unit[k]] = updated;
+        }
+    }
+
+    STATS_INC(propagations);
+}
+
+// scalar search for a lane that propagation alone could not finish
+bool finishPuzzle(unsigned short (&cells)[81])
+{
+    STATS_INC(nodes);
+
+    // most constrained cell
+    int bestCell = -1, bestCount = 10;
+    for (int cell = 0; cell < 81; ++cell)
+    {
+        int count = __builtin_popcount(cells[cell]);
+        if (count == 0)
+            return false;
+        if (count > 1 && count < bestCount)
+        {
+            bestCell = cell;
+            bestCount = count;
+        }
+    }
+
+    if (bestCell == -1)
+        return true;
+
+    for (int candidates = cells[bestCell]; candidates; candidates &= candidates - 1)
+    {
+        unsigned short copy[81];
+        for (int i = 0; i < 81; ++i)
+            copy[i] = cells[i];
+
+        // place the number and take it out of every peer, following any cells that become single
+        int stack[81], top = 0;
+        copy[bestCell] = candidates & -candidates;
+        stack[top++] = bestCell;
+        bool consistent = true;
+
+        while (top > 0 && consistent)
+        {
+            int cell = stack[--top];
+            int bit = copy[cell];
+            for (int peer : peerTables.peers[cell])
+            {
+                if (!(copy[peer] & bit))
+                    continue;
+                copy[peer] &= ~bit;
+                if (copy[peer] == 0)
+                {
+                    consistent = false;
+                    break;
+                }
+                if ((copy[peer] & (copy[peer] - 1)) == 0)
+                    stack[top++] = peer;
+            }
+        }
+
+        if (consistent && finishPuzzle(copy))
+        {
+            for (int i = 0; i < 81; ++i)
+                cells[i] = copy[i];
+            return true;
+        }
+        STATS_INC(backtracks);
+    }
+
+    return false;
+}
+
+void loadLane(LaneBoard &board, int lane, const Grid &grid)
+{
+    for (int i = 0; i < 81; ++i)
+    {
+        int value = grid.cells[i / 9][i % 9];
+        board.cells[i][lane] = value == 0 ? 0x1FF : 1 << (value - 1);
+    }
+}
+
+// an idle lane holds a solved looking board so it never changes, its result is ignored
+void clearLane(LaneBoard &board, int lane)
+{
+    for (int i = 0; i < 81; ++i)
+        board.cells[i][lane] = 1;
+}
+
+void storeLane(const unsigned short (&cells)[81], Grid &grid)
+{
+    for (int i = 0; i < 81; ++i)
+        grid.cells[i / 9][i % 9] = __builtin_ctz(cells[i]) + 1;
+}
+
+void solveBatch(Grid *grids, bool *solved, size_t count)
+{
+    LaneBoard board;
+    long owner[laneCount]; // index of the puzzle in each lane, -1 when idle
+    size_t next = 0;
+    int active = 0;
+
+    for (int lane = 0; lane < laneCount; ++lane)
+    {
+        if (next < count)
+        {
+            owner[lane] = next;
+            loadLane(board, lane, grids[next++]);
+            ++active;
+        }
+        else
+        {
+            owner[lane] = -1;
+            clearLane(board, lane);
+        }
+    }
+
+    while (active > 0)
+    {
+        Lanes changed = {}, dead = {};
+        sweep(board, changed, dead);
+
+        // cells with more than one candidate left
+        Lanes open = {};
+        for (int i = 0; i < 81; ++i)
+            open |= board.cells[i] & (board.cells[i] - 1);
+
+        for (int lane = 0; lane < laneCount; ++lane)
+        {
+            // a lane is only done once a sweep changes nothing, so the last sweep has checked the finished grid
+            if (owner[lane] < 0 || (changed[lane] != 0 && dead[lane] == 0))
+                continue;
+
+            // the lane is solved, impossible, or stuck and needs a search
+            long index = owner[lane];
+            unsigned short cells[81];
+            for (int i = 0; i < 81; ++i)
+                cells[i] = board.cells[i][lane];
+
+            if (dead[lane] != 0)
+                solved[index] = false;
+            else
+                solved[index] = (open[lane] == 0 || finishPuzzle(cells));
+            if (solved[index])
+                storeLane(cells, grids[index]);
+
+            // refill the lane with the next puzzle of the batch
+            if (next < count)
+            {
+                owner[lane] = next;
+                loadLane(board, lane, grids[next++]);
+            }
+            else
+            {
+                owner[lane] = -1;
+                clearLane(board, lane);
+                --active;
+            }
+        }
+    }
+}
+
+bool sudokuSolver(int (&grid)[9][9])
+{
+    Grid single;
+    for (int i = 0; i < 81; ++i)
+        single.cells[i / 9][i % 9] = grid[i / 9][i % 9];
+
+    bool solved;
+    solveBatch(&single, &solved, 1);
+
+    if (solved)
+        for (int i = 0; i < 81; ++i)
+            grid[i / 9][i % 9] = single.cells[i / 9][i % 9];
+    return solved;
+}
+
+} // namespace v9
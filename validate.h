@@ -0,0 +1,15 @@
+// check solved grids against their puzzles: every clue kept and every row, column and 3x3 grid holding 1 to 9
+
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <cstddef> // For size_t
+#include "solvers.h"
+
+// true if solution keeps every given of puzzle and all 27 units are complete
+bool validateSolution(const int (&puzzle)[9][9], const int (&solution)[9][9]);
+
+// same check for count grids at once, valid[i] says whether solutions[i] solves puzzles[i]
+void validateBatch(const Grid *puzzles, const Grid *solutions, bool *valid, size_t count);
+
+#endif